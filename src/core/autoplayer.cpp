@@ -0,0 +1,48 @@
+#include "autoplayer.hpp"
+#include <algorithm>
+
+AutoPlayer::AutoPlayer(BotConfig config)
+    : search(config), worker(&AutoPlayer::loop, this) {}
+
+AutoPlayer::~AutoPlayer() {
+    stopping = true;
+    requested.fetch_add(1, std::memory_order_release);
+    requested.notify_one();
+    worker.join();
+}
+
+std::uint64_t AutoPlayer::request(const Engine& engine) {
+    EngineSnapshot& s = snapshots.back();
+    s.id = ++lastId;
+    s.grid = engine.grid;
+    s.current = engine.current;
+    s.queueSize = std::min(static_cast<int>(engine.upcoming.size()), static_cast<int>(s.queue.size()));
+    for (int i = 0; i < s.queueSize; ++i) s.queue[i] = engine.upcoming[i].type;
+    snapshots.publish();
+
+    requested.fetch_add(1, std::memory_order_release);
+    requested.notify_one();
+    return lastId;
+}
+
+bool AutoPlayer::poll(BotPlan& plan) {
+    if (!plans.update()) return false;
+    plan = plans.front();
+    return true;
+}
+
+void AutoPlayer::loop() {
+    std::uint64_t seen = 0;
+    while (true) {
+        requested.wait(seen, std::memory_order_acquire);
+        seen = requested.load(std::memory_order_acquire);
+        if (stopping) return;
+        if (!snapshots.update()) continue;
+
+        const EngineSnapshot& s = snapshots.front();
+        BotPlan& out = plans.back();
+        out.id = s.id;
+        out.move = search.search(s.grid, s.current, s.queue.data(), s.queueSize);
+        plans.publish();
+    }
+}
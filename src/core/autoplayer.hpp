@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "bot.hpp"
+#include "engine.hpp"
+#include "triple_buffer.hpp"
+
+// What the bot needs to know about a game, copied out of the Engine.
+struct EngineSnapshot {
+    std::uint64_t id = 0;
+    Grid grid = {};
+    Tetromino current;
+    std::array<int, 5> queue = {};
+    int queueSize = 0;
+};
+
+struct BotPlan {
+    // id of the snapshot this plan was searched from
+    std::uint64_t id = 0;
+    BotMove move;
+};
+
+// Runs a BeamSearch on its own thread. The game thread hands over snapshots
+// and picks up finished plans through triple buffers, so neither side waits
+// on the other; the worker sleeps until a snapshot arrives.
+class AutoPlayer {
+public:
+    explicit AutoPlayer(BotConfig config = {});
+    ~AutoPlayer();
+
+    AutoPlayer(const AutoPlayer&) = delete;
+    AutoPlayer& operator=(const AutoPlayer&) = delete;
+
+    // Queues a search of the engine's current position and returns its id.
+    // A newer request replaces one the worker has not picked up yet.
+    std::uint64_t request(const Engine& engine);
+    // true if a plan finished since the last poll
+    bool poll(BotPlan& plan);
+
+private:
+    BeamSearch search;
+    TripleBuffer<EngineSnapshot> snapshots;
+    TripleBuffer<BotPlan> plans;
+    std::uint64_t lastId = 0;
+    std::atomic<std::uint64_t> requested{0};
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+
+    void loop();
+};
@@ -0,0 +1,201 @@
+#include "bot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include "zobrist.hpp"
+
+BoardEvaluator weightedEvaluator(const Weights& weights) {
+    return [weights](const Grid& grid, int lines) {
+        return evaluateBoard(grid, lines, weights);
+    };
+}
+
+BeamSearch::BeamSearch(BotConfig config, BoardEvaluator evaluator, ThreadPool* pool)
+    : settings(config), evaluate(std::move(evaluator)), pool(pool) {
+    settings.beamWidth = std::max(settings.beamWidth, 1);
+    settings.depth = std::max(settings.depth, 1);
+    const unsigned workers = pool ? pool->size() : 1;
+    for (unsigned i = 0; i < workers; ++i) scratch.push_back(std::make_unique<Scratch>());
+    children.resize(settings.beamWidth);
+    beam.reserve(PlacementList::CAPACITY);
+    candidates.reserve(PlacementList::CAPACITY);
+    if (settings.ttMegabytes) table = std::make_unique<TranspositionTable>(settings.ttMegabytes, workers);
+}
+
+template <class F>
+void BeamSearch::forEach(std::size_t count, F&& fn) {
+    if (pool) {
+        pool->parallelFor(count, fn);
+    } else {
+        for (std::size_t i = 0; i < count; ++i) fn(i, 0u);
+    }
+}
+
+void BeamSearch::keepBest(std::vector<Node>& nodes, int width) {
+    auto better = [](const Node& a, const Node& b) { return a.score > b.score; };
+    if (static_cast<int>(nodes.size()) > width) {
+        std::nth_element(nodes.begin(), nodes.begin() + width, nodes.end(), better);
+        nodes.resize(width);
+    }
+}
+
+// Keeps the first node of each distinct (board, lines) pair. Duplicates
+// score the same and expand into the same subtrees.
+void BeamSearch::dropDuplicates(std::vector<Node>& nodes) {
+    const std::size_t size = std::bit_ceil(nodes.size() * 2);
+    seen.assign(size, 0);
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        // zero marks an empty slot, so the empty board hashes as one
+        const std::uint64_t key = (nodes[i].hash ^ Zobrist::lines(nodes[i].lines)) | 1;
+        std::size_t slot = (key >> 17) & (size - 1);
+        while (seen[slot] && seen[slot] != key) slot = (slot + 1) & (size - 1);
+        if (seen[slot]) continue;
+        seen[slot] = key;
+        if (kept != i) nodes[kept] = nodes[i];
+        ++kept;
+    }
+    nodes.resize(kept);
+}
+
+float BeamSearch::score(const Grid& grid, std::uint64_t hash, int lines, unsigned worker) {
+    if (!table) return evaluate(grid, lines);
+
+    const std::uint64_t key = hash ^ Zobrist::lines(lines);
+    TTEntry entry;
+    if (table->probe(key, entry, worker)) return entry.value;
+    entry.value = evaluate(grid, lines);
+    entry.depth = 0;
+    table->store(key, entry, worker);
+    return entry.value;
+}
+
+BotMove BeamSearch::search(const Grid& grid, const Tetromino& current, const int* queue, int queueSize) {
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + settings.budget;
+    const bool timed = settings.budget.count() > 0;
+
+    BotMove move;
+    generator.generate(grid, current, roots);
+    if (roots.size == 0) return move;
+    if (table) table->newSearch();
+
+    const std::uint64_t rootHash = Zobrist::board(grid);
+    const int depth = std::min(settings.depth, queueSize + 1);
+
+    // The position's stored best placement goes first, so it wins ties. If it
+    // was searched at least as deep as this search would go, it is the answer.
+    std::uint64_t positionKey = 0;
+    if (table) {
+        int types[Zobrist::QUEUE_SLOTS];
+        int count = 0;
+        types[count++] = current.type;
+        for (int i = 0; i < queueSize && count < Zobrist::QUEUE_SLOTS; ++i) types[count++] = queue[i];
+        positionKey = rootHash ^ Zobrist::queue(types, count);
+
+        TTEntry entry;
+        if (table->probe(positionKey, entry) && entry.hasMove) {
+            for (int i = 0; i < roots.size; ++i) {
+                const Tetromino& p = roots[i].piece;
+                if (p.pos.x != entry.moveX || p.pos.y != entry.moveY || p.rotation != entry.moveRotation) continue;
+                std::swap(roots.items[0], roots.items[i]);
+                if (entry.depth >= depth) {
+                    move.found = true;
+                    move.target = roots[0].piece;
+                    move.score = entry.value;
+                    move.depthReached = entry.depth;
+                    generator.path(roots[0], move.inputs);
+                    return move;
+                }
+                break;
+            }
+        }
+    }
+
+    beam.resize(roots.size);
+    forEach(static_cast<std::size_t>(roots.size), [&](std::size_t i, unsigned worker) {
+        Node& n = beam[i];
+        n.grid = grid;
+        n.hash = Zobrist::place(n.grid, roots[static_cast<int>(i)].piece, rootHash, n.lines);
+        n.score = score(n.grid, n.hash, n.lines, worker);
+        n.root = static_cast<int>(i);
+    });
+    nodes += roots.size;
+    move.depthReached = 1;
+
+    for (int level = 1; level < depth; ++level) {
+        keepBest(beam, settings.beamWidth);
+
+        std::atomic<bool> outOfTime{false};
+        const Tetromino piece(queue[level - 1]);
+        forEach(beam.size(), [&](std::size_t i, unsigned worker) {
+            std::vector<Node>& out = children[i];
+            out.clear();
+            if (timed && Clock::now() > deadline) {
+                outOfTime = true;
+                return;
+            }
+
+            const Node& parent = beam[i];
+            Scratch& s = *scratch[worker];
+            s.generator.generate(parent.grid, piece, s.placements);
+            for (const Placement& p : s.placements) {
+                Node child{parent.grid, 0, 0.f, 0, parent.root};
+                child.hash = Zobrist::place(child.grid, p.piece, parent.hash, child.lines);
+                child.lines += parent.lines;
+                child.score = score(child.grid, child.hash, child.lines, worker);
+                out.push_back(child);
+            }
+        });
+        // a partial level would favour whichever parents were expanded first
+        if (outOfTime) break;
+
+        candidates.clear();
+        for (std::size_t i = 0; i < beam.size(); ++i)
+            candidates.insert(candidates.end(), children[i].begin(), children[i].end());
+        if (candidates.empty()) break;
+
+        nodes += candidates.size();
+        dropDuplicates(candidates);
+        beam.swap(candidates);
+        move.depthReached = level + 1;
+    }
+
+    // first best in index order, so ties resolve the same way every run
+    const Node* best = &beam[0];
+    for (const Node& n : beam)
+        if (n.score > best->score) best = &n;
+
+    move.found = true;
+    move.target = roots[best->root].piece;
+    move.score = best->score;
+    generator.path(roots[best->root], move.inputs);
+
+    if (table) {
+        TTEntry entry;
+        entry.value = move.score;
+        entry.depth = static_cast<std::uint8_t>(move.depthReached);
+        entry.hasMove = true;
+        entry.moveX = static_cast<std::int8_t>(move.target.pos.x);
+        entry.moveY = static_cast<std::int8_t>(move.target.pos.y);
+        entry.moveRotation = static_cast<std::uint8_t>(move.target.rotation);
+        table->store(positionKey, entry);
+    }
+    return move;
+}
+
+BotMove BeamSearch::search(const Engine& engine) {
+    int queue[5];
+    const int size = std::min(static_cast<int>(engine.upcoming.size()), 5);
+    for (int i = 0; i < size; ++i) queue[i] = engine.upcoming[i].type;
+    return search(engine.grid, engine.current, queue, size);
+}
+
+void playOut(Engine& engine, BeamSearch& bot, int maxPieces) {
+    const int last = engine.pieces + maxPieces;
+    while (!engine.gameOver && engine.pieces < last) {
+        const BotMove move = bot.search(engine);
+        if (move.found) engine.current = move.target;
+        engine.apply(Input::HardDrop);
+    }
+}
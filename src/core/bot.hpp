@@ -0,0 +1,104 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "engine.hpp"
+#include "evaluator.hpp"
+#include "movegen.hpp"
+#include "thread_pool.hpp"
+#include "transposition.hpp"
+
+// Scores a board after a placement; `lines` is the number of rows cleared
+// along the path that led to it. Higher is better. Called from several threads
+// at once when the search has a pool.
+using BoardEvaluator = std::function<float(const Grid& grid, int lines)>;
+
+BoardEvaluator weightedEvaluator(const Weights& weights = DEFAULT_WEIGHTS);
+
+struct BotConfig {
+    int beamWidth = 16;
+    // pieces searched including the current one; capped by the preview queue
+    int depth = 3;
+    // per-search wall-clock budget, 0 for none
+    std::chrono::microseconds budget{1000};
+    // transposition table for board evaluations, 0 for none
+    std::size_t ttMegabytes = 0;
+};
+
+struct BotMove {
+    bool found = false;
+    Tetromino target;
+    InputSequence inputs;
+    float score = 0.f;
+    // deepest level that was searched completely
+    int depthReached = 0;
+};
+
+// Beam search over the current piece and the preview queue: every level keeps
+// the `beamWidth` best boards and expands them with the next piece. Buffers
+// are kept between searches, so a warmed-up search does not allocate.
+//
+// With a pool, root placements and each level's parents are expanded in
+// parallel. Children are merged in parent order, so the chosen move does not
+// depend on the number of threads.
+//
+// Boards reached by different placement orders are merged by Zobrist hash
+// before each level is pruned. With a transposition table, evaluations are
+// also reused across levels and across searches, and each search stores its
+// chosen placement under the position (board plus queue). A later search of
+// the same position tries that placement first, and returns it outright when
+// it was searched at least as deep.
+class BeamSearch {
+public:
+    explicit BeamSearch(BotConfig config = {}, BoardEvaluator evaluator = weightedEvaluator(),
+                        ThreadPool* pool = nullptr);
+
+    BotMove search(const Grid& grid, const Tetromino& current, const int* queue, int queueSize);
+    BotMove search(const Engine& engine);
+
+    const BotConfig& config() const { return settings; }
+    // null unless config().ttMegabytes is set
+    const TranspositionTable* transpositions() const { return table.get(); }
+    // placements evaluated over the lifetime of this object
+    std::uint64_t nodes = 0;
+
+private:
+    struct Node {
+        Grid grid;
+        std::uint64_t hash;
+        float score;
+        int lines;
+        int root;
+    };
+
+    // per-worker search buffers
+    struct Scratch {
+        MoveGenerator generator;
+        PlacementList placements;
+    };
+
+    BotConfig settings;
+    BoardEvaluator evaluate;
+    ThreadPool* pool;
+    MoveGenerator generator;
+    PlacementList roots;
+    std::vector<std::unique_ptr<Scratch>> scratch;
+    std::vector<std::vector<Node>> children;
+    std::vector<Node> beam;
+    std::vector<Node> candidates;
+    std::unique_ptr<TranspositionTable> table;
+    std::vector<std::uint64_t> seen;
+
+    template <class F>
+    void forEach(std::size_t count, F&& fn);
+    void keepBest(std::vector<Node>& nodes, int width);
+    void dropDuplicates(std::vector<Node>& nodes);
+    float score(const Grid& grid, std::uint64_t hash, int lines, unsigned worker);
+};
+
+// Lets `bot` play `engine` until game over or `maxPieces` more pieces have
+// locked. Each chosen placement is hard-dropped straight into place rather
+// than replayed input by input.
+void playOut(Engine& engine, BeamSearch& bot, int maxPieces);
@@ -0,0 +1,208 @@
+#include "corpus.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TETRIS_HAVE_MMAP 1
+#endif
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'R', 'P', 'C'};
+// previous table offset and replay count ahead of each batch's offsets
+constexpr std::size_t TABLE_HEADER = 16;
+
+std::uint64_t get64(const std::uint8_t* p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+std::uint32_t get32(const std::uint8_t* p) {
+    std::uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= std::uint32_t(p[i]) << (8 * i);
+    return v;
+}
+
+void put64(std::uint8_t* p, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+void put32(std::uint8_t* p, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+// corpora can pass 2 GB, beyond what fseek's long reaches on some platforms
+bool seekTo(std::FILE* f, std::uint64_t offset) {
+#ifdef TETRIS_HAVE_MMAP
+    return fseeko(f, static_cast<off_t>(offset), SEEK_SET) == 0;
+#else
+    return std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0;
+#endif
+}
+
+bool seekToEnd(std::FILE* f, std::uint64_t& offset) {
+#ifdef TETRIS_HAVE_MMAP
+    if (fseeko(f, 0, SEEK_END) != 0) return false;
+    const off_t at = ftello(f);
+#else
+    if (std::fseek(f, 0, SEEK_END) != 0) return false;
+    const long at = std::ftell(f);
+#endif
+    if (at < 0) return false;
+    offset = static_cast<std::uint64_t>(at);
+    return true;
+}
+
+}
+
+ReplayCorpus::~ReplayCorpus() {
+    close();
+}
+
+bool ReplayCorpus::open(const char* path) {
+    close();
+#ifdef TETRIS_HAVE_MMAP
+    const int fd = ::open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                mapping = p;
+                data = static_cast<const std::uint8_t*>(p);
+                bytes = static_cast<std::size_t>(st.st_size);
+                // replays are read front to back
+                madvise(p, bytes, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+#endif
+    if (!mapping) {
+        if (!readBinaryFile(path, fallback)) return false;
+        data = fallback.data();
+        bytes = fallback.size();
+    }
+    if (!readHeader()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ReplayCorpus::close() {
+#ifdef TETRIS_HAVE_MMAP
+    if (mapping) munmap(mapping, bytes);
+#endif
+    mapping = nullptr;
+    fallback.clear();
+    data = nullptr;
+    batches.clear();
+    bytes = 0;
+    count = 0;
+}
+
+bool ReplayCorpus::readHeader() {
+    if (bytes < HEADER_SIZE || std::memcmp(data, MAGIC, 4) || get32(data + 4) != VERSION) return false;
+    const std::uint64_t n = get64(data + 8);
+    // Walk the tables from the last batch back to the first. Each one must
+    // lie before the one after it, so a corrupt chain cannot loop.
+    std::uint64_t remaining = n;
+    std::uint64_t limit = bytes;
+    for (std::uint64_t table = get64(data + 16); table; table = get64(data + table)) {
+        if (table < HEADER_SIZE || table >= limit || limit - table < TABLE_HEADER) return false;
+        const std::uint64_t size = get64(data + table + 8);
+        if (size > remaining || size > (limit - table - TABLE_HEADER) / 8) return false;
+        remaining -= size;
+        batches.push_back({static_cast<std::size_t>(remaining), static_cast<std::size_t>(table)});
+        limit = table;
+    }
+    if (remaining) return false;
+    std::reverse(batches.begin(), batches.end());
+    count = static_cast<std::size_t>(n);
+    return true;
+}
+
+bool ReplayCorpus::view(std::size_t index, ReplayView& out) const {
+    if (index >= count) return false;
+    // the last batch starting at or before `index`
+    const auto after = std::upper_bound(batches.begin(), batches.end(), index,
+                                        [](std::size_t i, const Batch& b) { return i < b.first; });
+    const Batch& batch = *(after - 1);
+    const std::uint64_t offset = get64(data + batch.table + TABLE_HEADER + 8 * (index - batch.first));
+    // a replay lies before its batch's table
+    if (offset < HEADER_SIZE || offset >= batch.table) return false;
+    return out.parse(data + offset, batch.table - static_cast<std::size_t>(offset));
+}
+
+bool ReplayCorpus::append(const char* path, const std::vector<std::vector<std::uint8_t>>& replays) {
+    std::uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, 4);
+    put32(header + 4, VERSION);
+    std::uint64_t count = 0;
+    std::uint64_t last = 0;
+    // end of the last complete batch; anything after it is left over from an
+    // interrupted append and gets written over
+    std::uint64_t at = HEADER_SIZE;
+
+    std::FILE* f = std::fopen(path, "r+b");
+    bool ok = true;
+    if (f) {
+        std::uint8_t table[TABLE_HEADER];
+        std::uint64_t end = 0;
+        ok = std::fread(header, 1, HEADER_SIZE, f) == HEADER_SIZE && !std::memcmp(header, MAGIC, 4) &&
+             get32(header + 4) == VERSION;
+        if (ok) {
+            count = get64(header + 8);
+            last = get64(header + 16);
+        }
+        ok = ok && seekToEnd(f, end);
+        if (ok && last) {
+            ok = last >= HEADER_SIZE && last <= end && seekTo(f, last) &&
+                 std::fread(table, 1, TABLE_HEADER, f) == TABLE_HEADER &&
+                 get64(table + 8) <= (end - last - TABLE_HEADER) / 8;
+            if (ok) at = last + TABLE_HEADER + 8 * get64(table + 8);
+        }
+    } else {
+        // start from a valid empty corpus, so a crash during the first
+        // append still leaves a file later appends accept
+        f = std::fopen(path, "w+b");
+        if (!f) return false;
+        ok = std::fwrite(header, 1, HEADER_SIZE, f) == HEADER_SIZE && std::fflush(f) == 0;
+    }
+    if (!ok || replays.empty()) return std::fclose(f) == 0 && ok;
+
+    // New replays and their table go after the last batch and the header is
+    // switched over last, so a crash part way leaves the old corpus intact.
+    std::vector<std::uint8_t> table(TABLE_HEADER + 8 * replays.size());
+    put64(table.data(), last);
+    put64(table.data() + 8, replays.size());
+    ok = seekTo(f, at);
+    for (std::size_t i = 0; ok && i < replays.size(); ++i) {
+        put64(table.data() + TABLE_HEADER + 8 * i, at);
+        ok = std::fwrite(replays[i].data(), 1, replays[i].size(), f) == replays[i].size();
+        at += replays[i].size();
+    }
+    const std::uint64_t tableOffset = at;
+    ok = ok && std::fwrite(table.data(), 1, table.size(), f) == table.size();
+    ok = ok && std::fflush(f) == 0;
+
+    put64(header + 8, count + replays.size());
+    put64(header + 16, tableOffset);
+    ok = ok && seekTo(f, 0) && std::fwrite(header, 1, HEADER_SIZE, f) == HEADER_SIZE;
+    ok = std::fclose(f) == 0 && ok;
+
+    // drop what is left of a longer interrupted append
+    std::error_code error;
+    const std::uint64_t end = tableOffset + table.size();
+    if (ok && std::filesystem::file_size(path, error) > end && !error) std::filesystem::resize_file(path, end, error);
+    return ok;
+}
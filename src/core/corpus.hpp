@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "replay.hpp"
+
+// Many replays in one file:
+//   "TRPC", version (4 bytes), count (8 bytes), last table offset (8 bytes), 0 (8 bytes)
+//   per appended batch:
+//     replays, back to back
+//     table: previous table offset (8 bytes, 0 for the first), replays in
+//     the batch (8 bytes), one 8-byte file offset per replay
+// The tables form a chain from the last batch back to the first. An append
+// writes its replays and its own table after the last table and only then
+// points the header at it, so it writes nothing but new data, and an
+// interrupted append loses only the new batch.
+class ReplayCorpus {
+public:
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t HEADER_SIZE = 32;
+
+    ReplayCorpus() = default;
+    ~ReplayCorpus();
+
+    ReplayCorpus(const ReplayCorpus&) = delete;
+    ReplayCorpus& operator=(const ReplayCorpus&) = delete;
+
+    // Maps the file read-only where mmap is available, otherwise reads it into
+    // memory. False if it is missing or malformed.
+    bool open(const char* path);
+    void close();
+
+    std::size_t size() const { return count; }
+    // Parses replay `index` in place; the view stays valid until close().
+    bool view(std::size_t index, ReplayView& out) const;
+    bool mapped() const { return mapping != nullptr; }
+
+    // Appends serialised replays, creating the file if needed.
+    static bool append(const char* path, const std::vector<std::vector<std::uint8_t>>& replays);
+
+private:
+    // one appended batch, in file order
+    struct Batch {
+        std::size_t first;
+        std::size_t table;
+    };
+
+    const std::uint8_t* data = nullptr;
+    std::size_t bytes = 0;
+    std::size_t count = 0;
+    std::vector<Batch> batches;
+    void* mapping = nullptr;
+    std::vector<std::uint8_t> fallback;
+
+    bool readHeader();
+};
@@ -0,0 +1,288 @@
+#include "dataset.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include "replay.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/types.h>
+#define TETRIS_HAVE_FSEEKO 1
+#endif
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'S', 'M', 'P'};
+constexpr std::size_t HEADER_SIZE = 8;
+constexpr std::size_t BLOCK_HEADER = 12;
+// keeps placement coordinates non-negative
+constexpr int COORD_BIAS = 4;
+
+void put16(std::vector<std::uint8_t>& out, std::uint32_t v) {
+    out.push_back(static_cast<std::uint8_t>(v));
+    out.push_back(static_cast<std::uint8_t>(v >> 8));
+}
+
+void put32(std::vector<std::uint8_t>& out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+std::uint32_t get16(const std::uint8_t* p) {
+    return p[0] | std::uint32_t(p[1]) << 8;
+}
+
+std::uint32_t get32(const std::uint8_t* p) {
+    std::uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= std::uint32_t(p[i]) << (8 * i);
+    return v;
+}
+
+// sample files can pass 2 GB, beyond what fseek's long reaches on some
+// platforms
+bool seekTo(std::FILE* f, std::uint64_t offset) {
+#ifdef TETRIS_HAVE_FSEEKO
+    return fseeko(f, static_cast<off_t>(offset), SEEK_SET) == 0;
+#else
+    return std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0;
+#endif
+}
+
+bool seekToEnd(std::FILE* f, std::uint64_t& offset) {
+#ifdef TETRIS_HAVE_FSEEKO
+    if (fseeko(f, 0, SEEK_END) != 0) return false;
+    const off_t at = ftello(f);
+#else
+    if (std::fseek(f, 0, SEEK_END) != 0) return false;
+    const long at = std::ftell(f);
+#endif
+    if (at < 0) return false;
+    offset = static_cast<std::uint64_t>(at);
+    return true;
+}
+
+// rows from the bottom up to the highest non-empty one
+int stackHeight(const std::array<RowMask, ROWS>& rows) {
+    for (int y = 0; y < ROWS; ++y)
+        if (rows[y]) return ROWS - y;
+    return 0;
+}
+
+// Length of the header plus every complete block of an existing file, or 0
+// if there is no sample file at `path`.
+std::uint64_t completeLength(const char* path) {
+    std::FILE* f = std::fopen(path, "rb");
+    if (!f) return 0;
+    std::uint8_t header[BLOCK_HEADER];
+    std::uint64_t length = 0;
+    std::error_code error;
+    const std::uint64_t size = std::filesystem::file_size(path, error);
+    if (!error && std::fread(header, 1, HEADER_SIZE, f) == HEADER_SIZE) {
+        length = HEADER_SIZE;
+        while (std::fread(header, 1, BLOCK_HEADER, f) == BLOCK_HEADER) {
+            const std::uint64_t block = BLOCK_HEADER + std::uint64_t(get32(header + 4)) * 8 +
+                                        std::uint64_t(get32(header)) * 9 + get32(header + 8);
+            if (size - length < block) break;
+            length += block;
+            if (!seekTo(f, length)) break;
+        }
+    }
+    std::fclose(f);
+    return length;
+}
+
+// Appends the samples of the block at `p` to `out` and moves `p` past it.
+bool decodeBlock(const std::uint8_t*& p, const std::uint8_t* end, std::vector<TrainingSample>& out) {
+    if (end - p < static_cast<std::ptrdiff_t>(BLOCK_HEADER)) return false;
+    const std::size_t n = get32(p);
+    const std::size_t runs = get32(p + 4);
+    const std::size_t rowBytes = get32(p + 8);
+    p += BLOCK_HEADER;
+    if (static_cast<std::size_t>(end - p) < runs * 8 + n * 9 + rowBytes) return false;
+
+    const std::size_t first = out.size();
+    out.resize(first + n);
+    TrainingSample* s = out.data() + first;
+    std::size_t at = 0;
+    for (std::size_t r = 0; r < runs; ++r, p += 8) {
+        const std::uint32_t game = get32(p);
+        const std::size_t length = get32(p + 4);
+        if (length > n - at) return false;
+        for (std::size_t i = 0; i < length; ++i) s[at++].game = game;
+    }
+    if (at != n) return false;
+
+    const std::uint8_t* heights = p;
+    const std::uint8_t* pieces = heights + n;
+    const std::uint8_t* placements = pieces + 3 * n;
+    const std::uint8_t* cleared = placements + 2 * n;
+    const std::uint8_t* future = cleared + n;
+    const std::uint8_t* rows = future + 2 * n;
+    const std::uint8_t* rowsEnd = rows + rowBytes;
+
+    std::uint64_t acc = 0;
+    int bits = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::uint32_t types = get16(pieces + 3 * i) | std::uint32_t(pieces[3 * i + 2]) << 16;
+        s[i].current = types & 7;
+        for (int q = 0; q < 5; ++q) s[i].queue[q] = (types >> (3 * (q + 1))) & 7;
+        const std::uint32_t placement = get16(placements + 2 * i);
+        s[i].x = static_cast<std::int8_t>(int(placement & 15) - COORD_BIAS);
+        s[i].y = static_cast<std::int8_t>(int(placement >> 4 & 31) - COORD_BIAS);
+        s[i].rotation = static_cast<std::uint8_t>(placement >> 9 & 3);
+        s[i].cleared = cleared[i] & 0x7F;
+        s[i].toppedOut = cleared[i] >> 7;
+        s[i].futureLines = static_cast<std::uint16_t>(get16(future + 2 * i));
+
+        if (heights[i] > ROWS) return false;
+        s[i].rows = {};
+        for (int y = ROWS - 1; y >= ROWS - heights[i]; --y) {
+            while (bits < COLS) {
+                if (rows == rowsEnd) return false;
+                acc |= std::uint64_t(*rows++) << bits;
+                bits += 8;
+            }
+            s[i].rows[y] = static_cast<RowMask>(acc & FULL_ROW);
+            acc >>= COLS;
+            bits -= COLS;
+        }
+    }
+    p = rowsEnd;
+    return true;
+}
+
+}
+
+SampleWriter::~SampleWriter() {
+    close();
+}
+
+bool SampleWriter::open(const char* path) {
+    close();
+    failed = false;
+    written = bytesOut = 0;
+    // a block torn by an earlier crash is cut off, so new blocks follow the
+    // last complete one
+    const std::uint64_t length = completeLength(path);
+    std::error_code error;
+    if (length && length != std::filesystem::file_size(path, error)) {
+        std::filesystem::resize_file(path, length, error);
+        if (error) return false;
+    }
+    file = std::fopen(path, "ab+");
+    if (!file) return false;
+    pending.reserve(BLOCK_SAMPLES);
+
+    // writes always land at the end; reading the header needs a seek to 0
+    std::uint8_t header[HEADER_SIZE];
+    if (seekTo(file, 0) && std::fread(header, 1, HEADER_SIZE, file) == HEADER_SIZE) {
+        if (std::memcmp(header, MAGIC, 4) != 0 || header[4] != VERSION) {
+            std::fclose(file);
+            file = nullptr;
+            return false;
+        }
+        // a stream switching from reading to writing needs a seek in between
+        std::uint64_t end = 0;
+        seekToEnd(file, end);
+        return true;
+    }
+    const std::uint8_t fresh[HEADER_SIZE] = {static_cast<std::uint8_t>(MAGIC[0]), static_cast<std::uint8_t>(MAGIC[1]),
+                                             static_cast<std::uint8_t>(MAGIC[2]), static_cast<std::uint8_t>(MAGIC[3]),
+                                             VERSION, 0, 0, 0};
+    std::uint64_t end = 0;
+    if (!seekToEnd(file, end) || end != 0) {
+        // too short to hold a header
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    failed = std::fwrite(fresh, 1, HEADER_SIZE, file) != HEADER_SIZE;
+    bytesOut += HEADER_SIZE;
+    return true;
+}
+
+void SampleWriter::add(const TrainingSample& sample) {
+    pending.push_back(sample);
+    if (pending.size() == BLOCK_SAMPLES) flush();
+}
+
+bool SampleWriter::close() {
+    if (!file) return true;
+    flush();
+    const bool ok = std::fclose(file) == 0 && !failed;
+    file = nullptr;
+    return ok;
+}
+
+void SampleWriter::flush() {
+    if (pending.empty()) return;
+    const std::size_t n = pending.size();
+
+    std::uint32_t runs = 1;
+    for (std::size_t i = 1; i < n; ++i) runs += pending[i].game != pending[i - 1].game;
+    std::size_t storedRows = 0;
+    for (const TrainingSample& s : pending) storedRows += stackHeight(s.rows);
+    const std::size_t rowBytes = (storedRows * COLS + 7) / 8;
+
+    buffer.clear();
+    put32(buffer, static_cast<std::uint32_t>(n));
+    put32(buffer, runs);
+    put32(buffer, static_cast<std::uint32_t>(rowBytes));
+
+    for (std::size_t i = 0; i < n;) {
+        std::size_t end = i + 1;
+        while (end < n && pending[end].game == pending[i].game) ++end;
+        put32(buffer, pending[i].game);
+        put32(buffer, static_cast<std::uint32_t>(end - i));
+        i = end;
+    }
+    for (const TrainingSample& s : pending) buffer.push_back(static_cast<std::uint8_t>(stackHeight(s.rows)));
+    for (const TrainingSample& s : pending) {
+        std::uint32_t types = s.current;
+        for (int q = 0; q < 5; ++q) types |= std::uint32_t(s.queue[q]) << (3 * (q + 1));
+        put16(buffer, types);
+        buffer.push_back(static_cast<std::uint8_t>(types >> 16));
+    }
+    for (const TrainingSample& s : pending)
+        put16(buffer, std::uint32_t(s.x + COORD_BIAS) | std::uint32_t(s.y + COORD_BIAS) << 4 |
+                          std::uint32_t(s.rotation) << 9);
+    for (const TrainingSample& s : pending) buffer.push_back(static_cast<std::uint8_t>(s.cleared | s.toppedOut << 7));
+    for (const TrainingSample& s : pending) put16(buffer, s.futureLines);
+
+    std::uint64_t acc = 0;
+    int bits = 0;
+    for (const TrainingSample& s : pending) {
+        for (int y = ROWS - 1; y >= ROWS - stackHeight(s.rows); --y) {
+            acc |= std::uint64_t(s.rows[y]) << bits;
+            bits += COLS;
+            while (bits >= 8) {
+                buffer.push_back(static_cast<std::uint8_t>(acc));
+                acc >>= 8;
+                bits -= 8;
+            }
+        }
+    }
+    if (bits) buffer.push_back(static_cast<std::uint8_t>(acc));
+
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) failed = true;
+    bytesOut += buffer.size();
+    written += n;
+    pending.clear();
+}
+
+bool readSamples(const char* path, std::vector<TrainingSample>& out) {
+    std::vector<std::uint8_t> bytes;
+    if (!readBinaryFile(path, bytes) || bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), MAGIC, 4) != 0 ||
+        bytes[4] != SampleWriter::VERSION)
+        return false;
+
+    const std::uint8_t* p = bytes.data() + HEADER_SIZE;
+    const std::uint8_t* end = bytes.data() + bytes.size();
+    while (p < end) {
+        const std::size_t first = out.size();
+        if (!decodeBlock(p, end, out)) {
+            out.resize(first);
+            return false;
+        }
+    }
+    return true;
+}
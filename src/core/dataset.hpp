@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "grid.hpp"
+
+// One bot decision for training an evaluator: the position, the placement
+// chosen from it and how the game went afterwards.
+struct TrainingSample {
+    // game index, so train and validation sets can be split by game
+    std::uint32_t game = 0;
+    std::array<RowMask, ROWS> rows = {};
+    std::uint8_t current = 0;
+    std::array<std::uint8_t, 5> queue = {};
+    std::int8_t x = 0;
+    std::int8_t y = 0;
+    std::uint8_t rotation = 0;
+    // lines cleared by this placement
+    std::uint8_t cleared = 0;
+    // lines cleared from this placement to the end of the game, saturating
+    std::uint16_t futureLines = 0;
+    // the game ended by topping out rather than at the piece cap
+    bool toppedOut = false;
+};
+
+// Append-only columnar sample file. Samples are buffered into blocks and each
+// block is written column by column, so a reader can pull one column without
+// decoding the rest. open() cuts off a block torn by a crash before it
+// appends, so a file cut short loses at most its last block.
+//
+// File layout, little-endian:
+//   "TSMP", version, 0, 0, 0
+//   blocks: samples (4 bytes), game runs (4 bytes), row bytes (4 bytes)
+//     games:      runs of (game 4 bytes, length 4 bytes)
+//     heights:    1 byte, rows from the bottom up to the highest filled one
+//     pieces:     3 bytes, current | queue[i] << 3 * (i + 1)
+//     placements: 2 bytes, x + 4 | (y + 4) << 4 | rotation << 9
+//     cleared:    1 byte, cleared | toppedOut << 7
+//     future:     2 bytes
+//     rows:       10 bits per stored row, bottom row first, sample after sample
+// Empty rows above the stack are never stored, which is most of a board.
+class SampleWriter {
+public:
+    static constexpr std::uint8_t VERSION = 1;
+    static constexpr std::size_t BLOCK_SAMPLES = 4096;
+
+    SampleWriter() = default;
+    ~SampleWriter();
+
+    SampleWriter(const SampleWriter&) = delete;
+    SampleWriter& operator=(const SampleWriter&) = delete;
+
+    // Opens `path` for appending, writing the header if it is new. False if it
+    // cannot be opened or is not a sample file.
+    bool open(const char* path);
+    void add(const TrainingSample& sample);
+    // Writes the pending block and closes. False if any write failed.
+    bool close();
+
+    std::uint64_t samples() const { return written + pending.size(); }
+    // bytes appended so far, headers included
+    std::uint64_t bytes() const { return bytesOut; }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<TrainingSample> pending;
+    std::vector<std::uint8_t> buffer;
+    std::uint64_t written = 0;
+    std::uint64_t bytesOut = 0;
+    bool failed = false;
+
+    void flush();
+};
+
+// Decodes every block of a sample file into `out`. False if the file is
+// missing or malformed; `out` then holds the blocks before the bad one.
+bool readSamples(const char* path, std::vector<TrainingSample>& out);
@@ -0,0 +1,129 @@
+#include "engine.hpp"
+#include <algorithm>
+#include "telemetry.hpp"
+#include "zobrist.hpp"
+
+Engine::Engine(std::uint64_t seed, RandomizerMode mode, int previewCount)
+    : current(0),
+      randomizer(seed, mode),
+      previewCount(std::clamp(previewCount, 1, 5)) {
+    fillQueue();
+}
+
+void Engine::restart() {
+    grid.clear();
+    boardHash = 0;
+    score = 0;
+    lines = 0;
+    pieces = 0;
+    gameOver = false;
+    gravityCounter = 0;
+    fillQueue();
+}
+
+bool Engine::apply(Input input) {
+    if (gameOver) return false;
+
+    switch (input) {
+        case Input::Left:
+            return current.move({-1, 0}, grid);
+        case Input::Right:
+            return current.move({1, 0}, grid);
+        case Input::SoftDrop:
+            return current.move({0, 1}, grid);
+        case Input::Rotate: {
+            const int before = current.rotation;
+            current.rotate(grid);
+            return current.rotation != before;
+        }
+        case Input::HardDrop:
+            while (current.move({0, 1}, grid)) {}
+            lockAndNext();
+            return true;
+    }
+    return false;
+}
+
+void Engine::tick() {
+    ++ticks;
+    if (gameOver) return;
+
+    if (++gravityCounter >= gravityTicks) {
+        gravityCounter = 0;
+        if (!current.move({0, 1}, grid)) lockAndNext();
+    }
+}
+
+void Engine::lockAndNext() {
+    const Tetromino placed = current;
+    const int scoreBefore = score;
+    int cleared = 0;
+    boardHash = Zobrist::place(grid, current, boardHash, cleared);
+    ++pieces;
+    lines += cleared;
+    score += cleared * 100;
+    if (cleared == 3) score += 100;
+    if (cleared == 4) score += 200;
+
+    current = upcoming.front();
+    upcoming.pop_front();
+    upcoming.push_back(Tetromino(nextType()));
+
+    if (!current.isValid(grid)) gameOver = true;
+
+    if (telemetry) {
+        PieceEvent e;
+        e.kind = PieceEventKind::Lock;
+        e.piece = static_cast<std::uint32_t>(pieces);
+        e.tick = ticks;
+        e.ticksInPlay = ticks - spawnTick;
+        e.scoreDelta = score - scoreBefore;
+        e.type = static_cast<std::uint8_t>(placed.type);
+        e.x = static_cast<std::int8_t>(placed.pos.x);
+        e.y = static_cast<std::int8_t>(placed.pos.y);
+        e.rotation = static_cast<std::uint8_t>(placed.rotation);
+        e.cleared = static_cast<std::uint8_t>(cleared);
+        e.gameOver = gameOver;
+        telemetry->emit(e);
+    }
+    spawned();
+}
+
+std::uint64_t Engine::hash() const {
+    int types[Zobrist::QUEUE_SLOTS];
+    int count = 0;
+    types[count++] = current.type;
+    for (std::size_t i = 0; i < upcoming.size() && count < Zobrist::QUEUE_SLOTS; ++i)
+        types[count++] = upcoming[i].type;
+    return boardHash ^ Zobrist::queue(types, count);
+}
+
+int Engine::nextType() {
+    return randomizer.next();
+}
+
+void Engine::fillQueue() {
+    upcoming.clear();
+    for (int i = 0; i < previewCount; ++i) {
+        upcoming.push_back(Tetromino(nextType()));
+    }
+    current = upcoming.front();
+    upcoming.pop_front();
+    upcoming.push_back(Tetromino(nextType()));
+    spawned();
+}
+
+void Engine::spawned() {
+    spawnTick = ticks;
+    if (!telemetry) return;
+    PieceEvent e;
+    e.kind = PieceEventKind::Spawn;
+    e.piece = static_cast<std::uint32_t>(pieces + 1);
+    e.tick = ticks;
+    e.type = static_cast<std::uint8_t>(current.type);
+    e.x = static_cast<std::int8_t>(current.pos.x);
+    e.y = static_cast<std::int8_t>(current.pos.y);
+    e.rotation = static_cast<std::uint8_t>(current.rotation);
+    e.gameOver = gameOver;
+    telemetry->emit(e);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "tetromino.hpp"
+#include "grid.hpp"
+#include "randomizer.hpp"
+
+class TelemetryWriter;
+
+enum class Input {
+    Left,
+    Right,
+    SoftDrop,
+    Rotate,
+    HardDrop,
+};
+
+// Fixed-capacity FIFO for the preview queue, so an Engine copies with one
+// memcpy and never allocates.
+struct PieceQueue {
+    static constexpr int CAPACITY = 8;
+
+    std::array<Tetromino, CAPACITY> items;
+    std::uint8_t head = 0;
+    std::uint8_t count = 0;
+
+    std::size_t size() const { return count; }
+    const Tetromino& operator[](std::size_t i) const { return items[(head + i) & (CAPACITY - 1)]; }
+    const Tetromino& front() const { return items[head]; }
+    void push_back(const Tetromino& t) { items[(head + count++) & (CAPACITY - 1)] = t; }
+    void pop_front() {
+        head = (head + 1) & (CAPACITY - 1);
+        --count;
+    }
+    void clear() { head = count = 0; }
+};
+
+// Game rules without any rendering or window: board, active piece, preview
+// queue, gravity and scoring. The SFML client and headless tools both drive
+// the game through this class.
+class Engine {
+public:
+    Grid grid = {};
+    Tetromino current;
+    PieceQueue upcoming;
+    Randomizer randomizer;
+
+    int previewCount = 5;
+    int score = 0;
+    int lines = 0;
+    // pieces locked since restart
+    int pieces = 0;
+    bool gameOver = false;
+
+    // gravity runs on fixed ticks so a game replays exactly from its inputs
+    static constexpr int TICK_RATE = 60;
+    int gravityTicks = TICK_RATE / 2;
+    int gravityCounter = 0;
+    // ticks since construction; restart() keeps counting
+    std::uint32_t ticks = 0;
+    // tick the current piece spawned on
+    std::uint32_t spawnTick = 0;
+
+    // receives a PieceEvent per spawn and lock when set; copies of the engine
+    // share it
+    TelemetryWriter* telemetry = nullptr;
+
+    explicit Engine(std::uint64_t seed = 0,
+                    RandomizerMode mode = RandomizerMode::Uniform,
+                    int previewCount = 5);
+
+    void restart();
+    bool apply(Input input);
+    void tick();
+
+    void lockAndNext();
+
+    // Zobrist hash of the board plus the active piece and preview queue
+    std::uint64_t hash() const;
+    // occupancy part of hash(), updated incrementally on lock and line clear
+    std::uint64_t boardHash = 0;
+
+private:
+    int nextType();
+    void fillQueue();
+    void spawned();
+};
+
+static_assert(std::is_trivially_copyable_v<Engine>);
@@ -0,0 +1,134 @@
+#include "evaluator.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+const Weights DEFAULT_WEIGHTS = {
+    -0.5f,   // AggregateHeight
+    -0.5f,   // MaxHeight
+    -7.9f,   // Holes
+    -1.0f,   // CoveredCells
+    -3.4f,   // WellDepth
+    -3.2f,   // RowTransitions
+    -9.3f,   // ColumnTransitions
+    -0.5f,   // Bumpiness
+    3.4f,    // LinesCleared
+};
+
+namespace {
+
+// Four 16-bit lanes per word, one board row per lane; lane 0 is the top row of the group.
+constexpr int LANES = 4;
+constexpr int WORDS = ROWS / LANES;
+static_assert(ROWS % LANES == 0, "rows must pack evenly into 64-bit words");
+
+constexpr std::uint64_t broadcast(std::uint64_t lane) {
+    return lane * 0x0001000100010001ull;
+}
+
+constexpr std::uint64_t lane(std::uint64_t word, int i) {
+    return (word >> (16 * i)) & 0xFFFF;
+}
+
+}
+
+BoardFeatures boardFeatures(const Grid& grid, int linesCleared) {
+    BoardFeatures f;
+    f.heights.fill(0);
+
+    std::array<std::uint64_t, WORDS> rows;
+    std::array<std::uint64_t, WORDS> holeWords;
+    for (int k = 0; k < WORDS; ++k) {
+        rows[k] = 0;
+        for (int i = 0; i < LANES; ++i) rows[k] |= std::uint64_t{grid.rows[k * LANES + i]} << (16 * i);
+    }
+
+    // walls on both sides count as filled
+    constexpr std::uint64_t WALLS = broadcast(1u | (1u << (COLS + 1)));
+    constexpr std::uint64_t EDGES = broadcast((1u << (COLS + 1)) - 1);
+
+    int holes = 0, rowTransitions = 0, columnTransitions = 0;
+    std::uint64_t seen = 0;    // columns filled in or above the last row processed
+    std::uint64_t above = 0;   // last row processed
+    for (int k = 0; k < WORDS; ++k) {
+        const std::uint64_t w = rows[k];
+
+        // prefix OR down the lanes, plus everything above this group
+        std::uint64_t covered = w | (w << 16);
+        covered |= covered << 32;
+        covered |= broadcast(seen);
+
+        // a column's top cell is where it first becomes covered
+        const std::uint64_t coveredAbove = (covered << 16) | seen;
+        for (std::uint64_t fresh = covered & ~coveredAbove; fresh; fresh &= fresh - 1) {
+            const int bit = std::countr_zero(fresh);
+            f.heights[bit % 16] = static_cast<std::uint8_t>(ROWS - (k * LANES + bit / 16));
+        }
+
+        holeWords[k] = covered & ~w;
+        holes += std::popcount(holeWords[k]);
+
+        const std::uint64_t walled = (w << 1) | WALLS;
+        rowTransitions += std::popcount((walled ^ (walled >> 1)) & EDGES);
+        columnTransitions += std::popcount(w ^ ((w << 16) | above));
+
+        seen = lane(covered, LANES - 1);
+        above = lane(w, LANES - 1);
+    }
+    // the floor counts as filled
+    columnTransitions += std::popcount(above ^ FULL_ROW);
+
+    // filled cells with a hole somewhere below them, walking up from the floor
+    int covered = 0;
+    std::uint64_t holeBelow = 0;
+    for (int k = WORDS - 1; k >= 0; --k) {
+        std::uint64_t inclusive = holeWords[k] | (holeWords[k] >> 16);
+        inclusive |= inclusive >> 32;
+        inclusive |= broadcast(holeBelow);
+        const std::uint64_t strict = (inclusive >> 16) | (holeBelow << 48);
+        covered += std::popcount(rows[k] & strict);
+        holeBelow = lane(inclusive, 0);
+    }
+
+    int aggregate = 0, maxHeight = 0, wellDepth = 0, bumpiness = 0;
+    for (int c = 0; c < COLS; ++c) {
+        const int h = f.heights[c];
+        const int left = c > 0 ? f.heights[c - 1] : ROWS;
+        const int right = c + 1 < COLS ? f.heights[c + 1] : ROWS;
+        const int well = std::max(0, std::min(left, right) - h);
+        f.wells[c] = static_cast<std::uint8_t>(well);
+        wellDepth += well;
+        aggregate += h;
+        maxHeight = std::max(maxHeight, h);
+        if (c + 1 < COLS) bumpiness += std::abs(h - right);
+    }
+
+    f.values[AggregateHeight] = static_cast<float>(aggregate);
+    f.values[MaxHeight] = static_cast<float>(maxHeight);
+    f.values[Holes] = static_cast<float>(holes);
+    f.values[CoveredCells] = static_cast<float>(covered);
+    f.values[WellDepth] = static_cast<float>(wellDepth);
+    f.values[RowTransitions] = static_cast<float>(rowTransitions);
+    f.values[ColumnTransitions] = static_cast<float>(columnTransitions);
+    f.values[Bumpiness] = static_cast<float>(bumpiness);
+    f.values[LinesCleared] = static_cast<float>(linesCleared);
+    return f;
+}
+
+float weightedScore(const FeatureVector& values, const Weights& weights) {
+    float score = 0.f;
+    for (int i = 0; i < FEATURE_COUNT; ++i) score += values[i] * weights[i];
+    return score;
+}
+
+float evaluateBoard(const Grid& grid, int linesCleared, const Weights& weights) {
+    return weightedScore(boardFeatures(grid, linesCleared).values, weights);
+}
+
+const char* featureName(int feature) {
+    static const char* names[FEATURE_COUNT] = {
+        "aggregate_height", "max_height", "holes", "covered_cells", "well_depth",
+        "row_transitions", "column_transitions", "bumpiness", "lines_cleared",
+    };
+    return names[feature];
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "grid.hpp"
+
+enum Feature : int {
+    AggregateHeight,
+    MaxHeight,
+    Holes,
+    CoveredCells,
+    WellDepth,
+    RowTransitions,
+    ColumnTransitions,
+    Bumpiness,
+    LinesCleared,
+    FEATURE_COUNT,
+};
+
+using FeatureVector = std::array<float, FEATURE_COUNT>;
+using Weights = FeatureVector;
+
+struct BoardFeatures {
+    std::array<std::uint8_t, COLS> heights;
+    std::array<std::uint8_t, COLS> wells;
+    FeatureVector values;
+};
+
+// Hand-set starting point; tetris_tune searches for better ones.
+extern const Weights DEFAULT_WEIGHTS;
+
+// Computes every feature in one top-down and one bottom-up pass over the row
+// masks; holes, covered cells and transitions are popcounts over whole rows
+// rather than per-cell loops.
+BoardFeatures boardFeatures(const Grid& grid, int linesCleared = 0);
+float weightedScore(const FeatureVector& values, const Weights& weights);
+// Higher is better.
+float evaluateBoard(const Grid& grid, int linesCleared, const Weights& weights);
+
+const char* featureName(int feature);
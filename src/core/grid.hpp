@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+constexpr int ROWS = 20;
+constexpr int COLS = 10;
+
+// One bit per column, bit x set when cell (x, y) is occupied.
+using RowMask = std::uint16_t;
+constexpr RowMask FULL_ROW = (1u << COLS) - 1;
+
+// Bitboard playfield. `rows` is the only thing collision and line clears look
+// at; `colors` keeps a 4-bit color index per cell for rendering.
+struct Grid {
+    std::array<RowMask, ROWS> rows = {};
+    std::array<std::uint64_t, ROWS> colors = {};
+
+    // Single-cell query for drawing and tools; collision goes through
+    // collides() in shapes.hpp, which tests a whole piece row with one AND.
+    bool occupied(int x, int y) const {
+        return (rows[y] >> x) & 1u;
+    }
+
+    int color(int x, int y) const {
+        return static_cast<int>((colors[y] >> (x * 4)) & 0xF);
+    }
+
+    void set(int x, int y, int color) {
+        rows[y] |= static_cast<RowMask>(1u << x);
+        colors[y] = (colors[y] & ~(std::uint64_t{0xF} << (x * 4)))
+                  | (static_cast<std::uint64_t>(color & 0xF) << (x * 4));
+    }
+
+    bool isFull(int y) const {
+        return rows[y] == FULL_ROW;
+    }
+
+    // Drops every full row and shifts the rows above it down. Returns the
+    // number of rows removed.
+    int clearFullRows() {
+        int dst = ROWS - 1;
+        for (int src = ROWS - 1; src >= 0; --src) {
+            if (rows[src] == FULL_ROW) continue;
+            rows[dst] = rows[src];
+            colors[dst] = colors[src];
+            --dst;
+        }
+        const int cleared = dst + 1;
+        for (; dst >= 0; --dst) {
+            rows[dst] = 0;
+            colors[dst] = 0;
+        }
+        return cleared;
+    }
+
+    void clear() {
+        rows.fill(0);
+        colors.fill(0);
+    }
+};
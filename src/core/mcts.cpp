@@ -0,0 +1,346 @@
+#include "mcts.hpp"
+#include <algorithm>
+#include <cmath>
+#include "shapes.hpp"
+
+MonteCarloSearch::MonteCarloSearch(MctsConfig config, BoardEvaluator evaluator)
+    : settings(config), evaluate(std::move(evaluator)), rng(config.seed) {
+    settings.rolloutDepth = std::max(settings.rolloutDepth, 0);
+    const std::size_t capacity =
+        std::max<std::size_t>(settings.memoryMegabytes * 1024 * 1024 / 2 / sizeof(Node), PlacementList::CAPACITY + 1);
+    arena.resize(capacity);
+    spare.resize(capacity);
+    path.reserve(256);
+}
+
+// ---- tree bookkeeping ----------------------------------------------------------
+
+int MonteCarloSearch::typeAt(int pieceDepth) const {
+    if (pieceDepth == 0) return current.type;
+    return pieceDepth <= queueSize ? queue[pieceDepth - 1] : -1;
+}
+
+int MonteCarloSearch::sampleType() {
+    std::uint64_t z = (rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<int>(((z >> 32) * PIECE_TYPES) >> 32);
+}
+
+std::uint32_t MonteCarloSearch::allocate(std::size_t count) {
+    if (used + count > arena.size()) return NONE;
+    const auto first = static_cast<std::uint32_t>(used);
+    used += count;
+    return first;
+}
+
+Grid MonteCarloSearch::gridOf(const Node& n) const {
+    Grid g;
+    g.rows = n.rows;
+    return g;
+}
+
+void MonteCarloSearch::reset(const Grid& grid, const Tetromino& piece, const int* types, int count) {
+    current = piece;
+    queueSize = std::min(count, QUEUE_CAPACITY);
+    std::copy(types, types + queueSize, queue.begin());
+
+    used = 0;
+    root = allocate(1);
+    Node& r = arena[root];
+    r = {};
+    r.rows = grid.rows;
+    r.firstChild = NONE;
+    r.nextType = static_cast<std::int8_t>(current.type);
+    r.type = static_cast<std::int8_t>(current.type);
+    haveValues = false;
+}
+
+void MonteCarloSearch::reset(const Engine& engine) {
+    int types[QUEUE_CAPACITY];
+    const int count = std::min(static_cast<int>(engine.upcoming.size()), QUEUE_CAPACITY);
+    for (int i = 0; i < count; ++i) types[i] = engine.upcoming[i].type;
+    reset(engine.grid, engine.current, types, count);
+}
+
+void MonteCarloSearch::expand(std::uint32_t index, int pieceDepth) {
+    Node& n = arena[index];
+    if (n.expanded || n.dead) return;
+
+    if (n.nextType < 0) {
+        // chance node: one child per piece type, same board
+        const std::uint32_t first = allocate(PIECE_TYPES);
+        if (first == NONE) return;
+        for (int t = 0; t < PIECE_TYPES; ++t) {
+            Node& c = arena[first + t];
+            c = n;
+            c.total = 0.f;
+            c.visits = 0;
+            c.firstChild = NONE;
+            c.childCount = 0;
+            c.expanded = false;
+            c.nextType = static_cast<std::int8_t>(t);
+        }
+        n.firstChild = first;
+        n.childCount = PIECE_TYPES;
+        n.expanded = true;
+        return;
+    }
+
+    const Grid grid = gridOf(n);
+    generator.generate(grid, Tetromino(n.nextType), placements);
+    if (placements.size == 0) {
+        n.dead = true;
+        return;
+    }
+    const std::uint32_t first = allocate(placements.size);
+    if (first == NONE) return;
+
+    const int nextType = typeAt(pieceDepth + 1);
+    for (int i = 0; i < placements.size; ++i) {
+        const Tetromino& p = placements[i].piece;
+        Grid g = grid;
+        p.lock(g);
+        Node& c = arena[first + i];
+        c = {};
+        c.lines = n.lines + g.clearFullRows();
+        c.rows = g.rows;
+        c.firstChild = NONE;
+        c.nextType = static_cast<std::int8_t>(nextType);
+        c.type = static_cast<std::int8_t>(p.type);
+        c.x = static_cast<std::int8_t>(p.pos.x);
+        c.y = static_cast<std::int8_t>(p.pos.y);
+        c.rotation = static_cast<std::int8_t>(p.rotation);
+    }
+    n.firstChild = first;
+    n.childCount = static_cast<std::uint16_t>(placements.size);
+    n.expanded = true;
+}
+
+// ---- search --------------------------------------------------------------------
+
+std::uint32_t MonteCarloSearch::select(const Node& n) const {
+    const float range = maxValue > minValue ? maxValue - minValue : 1.f;
+    const float logVisits = std::log(static_cast<float>(std::max(n.visits, 1u)));
+    std::uint32_t best = n.firstChild;
+    float bestScore = -1.f;
+    for (std::uint32_t i = n.firstChild; i < n.firstChild + n.childCount; ++i) {
+        const Node& c = arena[i];
+        if (c.visits == 0) return i;
+        const float q = (c.total / c.visits - minValue) / range;
+        const float score = q + settings.exploration * std::sqrt(logVisits / c.visits);
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    return best;
+}
+
+float MonteCarloSearch::rollout(const Node& n, int pieceDepth) {
+    Grid grid = gridOf(n);
+    int lines = n.lines;
+    int type = n.nextType;
+    if (settings.rolloutDepth == 0) return evaluate(grid, lines);
+
+    float value = 0.f;
+    for (int k = 0; k < settings.rolloutDepth; ++k) {
+        if (type < 0) type = sampleType();
+        generator.generate(grid, Tetromino(type), placements);
+        if (placements.size == 0) return haveValues ? minValue : evaluate(grid, lines);
+
+        // greedy: keep the best-scoring placement of this piece
+        Grid bestGrid;
+        int bestLines = 0;
+        value = 0.f;
+        for (int i = 0; i < placements.size; ++i) {
+            Grid g = grid;
+            placements[i].piece.lock(g);
+            const int l = lines + g.clearFullRows();
+            const float v = evaluate(g, l);
+            if (i == 0 || v > value) {
+                value = v;
+                bestGrid = g;
+                bestLines = l;
+            }
+        }
+        grid = bestGrid;
+        lines = bestLines;
+        type = typeAt(pieceDepth + k + 1);
+    }
+    return value;
+}
+
+void MonteCarloSearch::playout() {
+    path.clear();
+    std::uint32_t index = root;
+    int pieceDepth = 0;
+    while (true) {
+        path.push_back(index);
+        Node& n = arena[index];
+        if (n.dead) break;
+        if (!n.expanded) {
+            // a leaf is only expanded once it has been scored itself
+            if (n.visits == 0 && index != root) break;
+            expand(index, pieceDepth);
+            if (!n.expanded) break;
+        }
+        if (n.nextType < 0) {
+            index = n.firstChild + sampleType();
+        } else {
+            index = select(n);
+            ++pieceDepth;
+        }
+    }
+
+    const Node& leaf = arena[path.back()];
+    const float value = leaf.dead ? (haveValues ? minValue : evaluate(gridOf(leaf), leaf.lines))
+                            : rollout(leaf, pieceDepth);
+    if (!haveValues) {
+        minValue = maxValue = value;
+        haveValues = true;
+    }
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+
+    for (std::uint32_t i : path) {
+        arena[i].visits += 1;
+        arena[i].total += value;
+    }
+    ++playouts;
+}
+
+int MonteCarloSearch::step(std::int64_t budgetUs) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::microseconds(budgetUs);
+    int count = 0;
+    do {
+        playout();
+        ++count;
+    } while (Clock::now() < deadline);
+    searchTime += Clock::now() - start;
+    return count;
+}
+
+BotMove MonteCarloSearch::best() {
+    BotMove move;
+    expand(root, 0);
+    const Node& r = arena[root];
+    if (!r.expanded || r.childCount == 0) return move;
+
+    std::uint32_t best = r.firstChild;
+    for (std::uint32_t i = r.firstChild; i < r.firstChild + r.childCount; ++i) {
+        const Node& c = arena[i];
+        const Node& b = arena[best];
+        if (c.visits > b.visits || (c.visits == b.visits && c.visits && c.total / c.visits > b.total / b.visits))
+            best = i;
+    }
+
+    // the root's placements are regenerated to recover the input path
+    const Node& chosen = arena[best];
+    generator.generate(gridOf(r), current, placements);
+    for (const Placement& p : placements) {
+        if (p.piece.pos.x != chosen.x || p.piece.pos.y != chosen.y || p.piece.rotation != chosen.rotation) continue;
+        move.found = true;
+        move.target = p.piece;
+        move.score = chosen.visits ? chosen.total / chosen.visits : 0.f;
+        move.depthReached = 1;
+        generator.path(p, move.inputs);
+        break;
+    }
+    return move;
+}
+
+// ---- re-rooting ----------------------------------------------------------------
+
+// Copies the subtree at `src` into `spare`. Returns NONE if it does not fit or
+// disagrees with the new queue.
+std::uint32_t MonteCarloSearch::copyTree(std::uint32_t src, int pieceDepth, std::size_t& usedOut) {
+    if (usedOut + 1 > spare.size()) return NONE;
+    const auto dst = static_cast<std::uint32_t>(usedOut++);
+    if (!copyInto(src, dst, pieceDepth, usedOut)) return NONE;
+    return dst;
+}
+
+bool MonteCarloSearch::copyInto(std::uint32_t src, std::uint32_t dst, int pieceDepth, std::size_t& usedOut) {
+    const Node* n = &arena[src];
+    const int known = typeAt(pieceDepth);
+    if (n->nextType < 0 && known >= 0) {
+        // the new preview piece decides this chance node
+        if (n->expanded) {
+            n = &arena[n->firstChild + known];
+        } else {
+            spare[dst] = *n;
+            spare[dst].nextType = static_cast<std::int8_t>(known);
+            return true;
+        }
+    } else if (n->nextType >= 0 && known >= 0 && n->nextType != known) {
+        return false;
+    }
+
+    Node& out = spare[dst];
+    out = *n;
+    if (!n->expanded) return true;
+    if (usedOut + n->childCount > spare.size()) return false;
+    out.firstChild = static_cast<std::uint32_t>(usedOut);
+    usedOut += n->childCount;
+
+    const int childDepth = n->nextType < 0 ? pieceDepth : pieceDepth + 1;
+    for (std::uint16_t i = 0; i < n->childCount; ++i)
+        if (!copyInto(n->firstChild + i, out.firstChild + i, childDepth, usedOut)) return false;
+    return true;
+}
+
+void MonteCarloSearch::advance(const Tetromino& placed, const Grid& grid, const Tetromino& piece,
+                               const int* types, int count) {
+    const Node& r = arena[root];
+    std::uint32_t child = NONE;
+    if (r.expanded) {
+        for (std::uint32_t i = r.firstChild; i < r.firstChild + r.childCount; ++i) {
+            const Node& c = arena[i];
+            if (c.x == placed.pos.x && c.y == placed.pos.y && c.rotation == placed.rotation) {
+                child = i;
+                break;
+            }
+        }
+    }
+    if (child == NONE || arena[child].rows != grid.rows || arena[child].nextType != piece.type) {
+        reset(grid, piece, types, count);
+        return;
+    }
+
+    current = piece;
+    queueSize = std::min(count, QUEUE_CAPACITY);
+    std::copy(types, types + queueSize, queue.begin());
+
+    std::size_t spareUsed = 0;
+    const std::uint32_t newRoot = copyTree(child, 0, spareUsed);
+    if (newRoot == NONE) {
+        reset(grid, piece, types, count);
+        return;
+    }
+    arena.swap(spare);
+    used = spareUsed;
+    root = newRoot;
+}
+
+void MonteCarloSearch::advance(const Tetromino& placed, const Engine& engine) {
+    int types[QUEUE_CAPACITY];
+    const int count = std::min(static_cast<int>(engine.upcoming.size()), QUEUE_CAPACITY);
+    for (int i = 0; i < count; ++i) types[i] = engine.upcoming[i].type;
+    advance(placed, engine.grid, engine.current, types, count);
+}
+
+MctsStats MonteCarloSearch::stats() const {
+    MctsStats s;
+    s.playouts = playouts;
+    const double seconds = std::chrono::duration<double>(searchTime).count();
+    s.playoutsPerSec = seconds > 0.0 ? playouts / seconds : 0.0;
+    s.nodes = used;
+    s.bytes = used * sizeof(Node);
+    s.capacityBytes = (arena.size() + spare.size()) * sizeof(Node);
+    s.rootVisits = arena[root].visits;
+    return s;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bot.hpp"
+#include "engine.hpp"
+#include "movegen.hpp"
+
+struct MctsConfig {
+    // split between the live tree and the arena it is compacted into on advance()
+    std::size_t memoryMegabytes = 64;
+    // greedy placements played past a leaf before it is scored
+    int rolloutDepth = 1;
+    float exploration = 1.4f;
+    // seeds the sampling of pieces past the preview queue
+    std::uint64_t seed = 0;
+};
+
+struct MctsStats {
+    std::uint64_t playouts = 0;
+    double playoutsPerSec = 0.0;
+    std::size_t nodes = 0;
+    std::size_t bytes = 0;
+    std::size_t capacityBytes = 0;
+    std::uint32_t rootVisits = 0;
+};
+
+// Anytime Monte Carlo tree search over placements. Pieces in the preview queue
+// are known; past it the tree has chance nodes with one child per piece type,
+// and playouts sample the type uniformly. Leaves are scored by a short greedy
+// rollout and the board evaluator, with values normalised to the range seen so
+// far for UCT.
+//
+// Nodes live in a fixed arena of indices, so search never allocates. After a
+// move, advance() copies the chosen subtree into a second arena and swaps,
+// resolving the chance nodes the newly revealed preview piece decides.
+class MonteCarloSearch {
+public:
+    explicit MonteCarloSearch(MctsConfig config = {}, BoardEvaluator evaluator = weightedEvaluator());
+
+    void reset(const Grid& grid, const Tetromino& current, const int* queue, int queueSize);
+    void reset(const Engine& engine);
+    // Re-roots at the child reached by `placed`. Falls back to reset() when that
+    // child was never expanded or does not lead to `grid`.
+    void advance(const Tetromino& placed, const Grid& grid, const Tetromino& current,
+                 const int* queue, int queueSize);
+    void advance(const Tetromino& placed, const Engine& engine);
+
+    // Runs playouts until `budgetUs` microseconds have passed, at least one.
+    // Returns the number run.
+    int step(std::int64_t budgetUs);
+    // Most visited root placement.
+    BotMove best();
+
+    MctsStats stats() const;
+
+private:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFF;
+    static constexpr int QUEUE_CAPACITY = 6;
+
+    struct Node {
+        std::array<RowMask, ROWS> rows;
+        float total;
+        std::uint32_t visits;
+        std::uint32_t firstChild;
+        std::uint16_t childCount;
+        // piece placed from this node, -1 for a chance node
+        std::int8_t nextType;
+        bool expanded;
+        bool dead;
+        // placement that led here
+        std::int8_t type, x, y, rotation;
+        std::int32_t lines;
+    };
+
+    MctsConfig settings;
+    BoardEvaluator evaluate;
+    MoveGenerator generator;
+    PlacementList placements;
+
+    std::vector<Node> arena;
+    std::vector<Node> spare;
+    std::size_t used = 0;
+    std::uint32_t root = 0;
+
+    Tetromino current;
+    std::array<int, QUEUE_CAPACITY> queue = {};
+    int queueSize = 0;
+
+    std::uint64_t rng = 0;
+    float minValue = 0.f;
+    float maxValue = 0.f;
+    bool haveValues = false;
+
+    std::uint64_t playouts = 0;
+    std::chrono::nanoseconds searchTime{0};
+    std::vector<std::uint32_t> path;
+
+    int typeAt(int pieceDepth) const;
+    int sampleType();
+    std::uint32_t allocate(std::size_t count);
+    Grid gridOf(const Node& n) const;
+
+    void expand(std::uint32_t index, int pieceDepth);
+    std::uint32_t select(const Node& n) const;
+    float rollout(const Node& n, int pieceDepth);
+    void playout();
+    std::uint32_t copyTree(std::uint32_t src, int pieceDepth, std::size_t& usedOut);
+    bool copyInto(std::uint32_t src, std::uint32_t dst, int pieceDepth, std::size_t& usedOut);
+};
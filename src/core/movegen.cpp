@@ -0,0 +1,108 @@
+#include "movegen.hpp"
+#include <algorithm>
+#include "rotation.hpp"
+#include "shapes.hpp"
+
+namespace {
+
+// Order-independent identity of the four cells a piece covers, so rotation
+// states that fill the same cells count as one placement.
+std::uint64_t cellKey(const Tetromino& t) {
+    const std::array<Point, 4>& blocks = t.blocks();
+    std::array<std::uint16_t, 4> cells;
+    for (int i = 0; i < 4; ++i)
+        cells[i] = static_cast<std::uint16_t>((blocks[i].y + t.pos.y + 8) * 16 + blocks[i].x + t.pos.x + 8);
+    std::sort(cells.begin(), cells.end());
+    return std::uint64_t{cells[0]} | std::uint64_t{cells[1]} << 16
+         | std::uint64_t{cells[2]} << 32 | std::uint64_t{cells[3]} << 48;
+}
+
+}
+
+void MoveGenerator::generate(const Grid& grid, const Tetromino& start, PlacementList& out) {
+    out.size = 0;
+    if (!start.isValid(grid)) return;
+
+    type = start.type;
+    root = index(start.rotation, start.pos.x, start.pos.y);
+    visited.fill(0);
+
+    int head = 0, tail = 0;
+    auto push = [&](int rotation, int x, int y, int from, Edge edge) {
+        const int n = index(rotation, x, y);
+        const std::uint64_t bit = std::uint64_t{1} << (n & 63);
+        if (visited[n >> 6] & bit) return;
+        visited[n >> 6] |= bit;
+        parent[n] = static_cast<std::uint16_t>(from);
+        via[n] = edge;
+        queue[tail++] = static_cast<std::uint16_t>(n);
+    };
+
+    push(start.rotation, start.pos.x, start.pos.y, root, Root);
+    while (head < tail) {
+        const int n = queue[head++];
+        const int x = n % X_SPAN + X_MIN;
+        const int y = (n / X_SPAN) % Y_SPAN + Y_MIN;
+        const int rotation = n / (X_SPAN * Y_SPAN);
+        ++nodes;
+
+        if (!collides(grid, type, rotation, {x - 1, y})) push(rotation, x - 1, y, n, Left);
+        if (!collides(grid, type, rotation, {x + 1, y})) push(rotation, x + 1, y, n, Right);
+
+        Point kicked{x, y};
+        if (kickRotation(grid, type, rotation, kicked)) push((rotation + 1) & 3, kicked.x, kicked.y, n, Rotate);
+
+        if (!collides(grid, type, rotation, {x, y + 1})) {
+            push(rotation, x, y + 1, n, Soft);
+            int floor = y + 1;
+            while (!collides(grid, type, rotation, {x, floor + 1})) ++floor;
+            push(rotation, x, floor, n, Sonic);
+            continue;
+        }
+
+        // resting on something: this is a lock position
+        Tetromino t(type);
+        t.rotation = rotation;
+        t.pos = {x, y};
+
+        const std::uint64_t key = cellKey(t);
+        if (std::find(keys.begin(), keys.begin() + out.size, key) != keys.begin() + out.size) continue;
+        if (out.size == PlacementList::CAPACITY) continue;
+        keys[out.size] = key;
+        out.items[out.size++] = {t, static_cast<std::uint16_t>(n)};
+    }
+}
+
+bool MoveGenerator::path(const Placement& p, InputSequence& out) const {
+    // walk back to the root, then emit forwards
+    std::array<std::uint16_t, STATES> chain;
+    int length = 0;
+    for (int n = p.node; n != root; n = parent[n]) chain[length++] = static_cast<std::uint16_t>(n);
+
+    out.size = 0;
+    auto emit = [&](Input in) {
+        if (out.size == InputSequence::CAPACITY) return false;
+        out.inputs[out.size++] = in;
+        return true;
+    };
+
+    for (int i = length - 1; i >= 0; --i) {
+        const int n = chain[i];
+        switch (via[n]) {
+            case Left: if (!emit(Input::Left)) return false; break;
+            case Right: if (!emit(Input::Right)) return false; break;
+            case Rotate: if (!emit(Input::Rotate)) return false; break;
+            case Soft: if (!emit(Input::SoftDrop)) return false; break;
+            case Sonic: {
+                // the final hard drop covers a trailing sonic drop
+                if (i == 0) break;
+                const int rows = (n / X_SPAN) % Y_SPAN - (parent[n] / X_SPAN) % Y_SPAN;
+                for (int k = 0; k < rows; ++k)
+                    if (!emit(Input::SoftDrop)) return false;
+                break;
+            }
+            default: break;
+        }
+    }
+    return emit(Input::HardDrop);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "engine.hpp"
+#include "grid.hpp"
+#include "tetromino.hpp"
+
+// A distinct final resting position, plus the search node it was found at so
+// MoveGenerator::path() can rebuild the inputs that reach it.
+struct Placement {
+    Tetromino piece;
+    std::uint16_t node;
+};
+
+struct PlacementList {
+    static constexpr int CAPACITY = 512;
+
+    std::array<Placement, CAPACITY> items;
+    int size = 0;
+
+    const Placement* begin() const { return items.data(); }
+    const Placement* end() const { return items.data() + size; }
+    const Placement& operator[](int i) const { return items[i]; }
+};
+
+struct InputSequence {
+    static constexpr int CAPACITY = 128;
+
+    std::array<Input, CAPACITY> inputs;
+    int size = 0;
+};
+
+// Breadth-first search over (x, y, rotation) using Tetromino::move and
+// applyRotation, so every tuck, spin and kick the player can perform is found.
+// All buffers are fixed-size members: a search never allocates.
+class MoveGenerator {
+public:
+    // pieces this far outside the board cannot exist, so the state space is bounded
+    static constexpr int X_MIN = -4, X_SPAN = 16;
+    static constexpr int Y_MIN = -4, Y_SPAN = 32;
+    static constexpr int STATES = X_SPAN * Y_SPAN * 4;
+
+    // total nodes expanded by every generate() call, for throughput reporting
+    std::uint64_t nodes = 0;
+
+    // Every distinct lock position reachable from `start`. Empty if `start` is
+    // already blocked. Placements stay valid for path() until the next call.
+    void generate(const Grid& grid, const Tetromino& start, PlacementList& out);
+    // Inputs leading from `start` to `p`, ending with HardDrop. Returns false
+    // if the sequence does not fit.
+    bool path(const Placement& p, InputSequence& out) const;
+
+private:
+    // edges of the search; Sonic is a drop to the floor without locking
+    enum Edge : std::uint8_t { Left, Right, Rotate, Soft, Sonic, Root };
+
+    int type = 0;
+    int root = 0;
+    std::array<std::uint64_t, STATES / 64> visited;
+    std::array<std::uint16_t, STATES> queue;
+    std::array<std::uint16_t, STATES> parent;
+    std::array<std::uint8_t, STATES> via;
+    std::array<std::uint64_t, PlacementList::CAPACITY> keys;
+
+    static int index(int rotation, int x, int y) {
+        return (rotation * Y_SPAN + (y - Y_MIN)) * X_SPAN + (x - X_MIN);
+    }
+};
@@ -0,0 +1,66 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <fstream>
+
+void FrameProfiler::beginFrame() {
+    pending.fill(0.f);
+    frameStart = Clock::now();
+    lastMark = frameStart;
+}
+
+void FrameProfiler::mark(FramePhase phase) {
+    const auto now = Clock::now();
+    pending[static_cast<int>(phase)] += std::chrono::duration<float, std::micro>(now - lastMark).count();
+    lastMark = now;
+}
+
+void FrameProfiler::endFrame() {
+    pending[PHASES] = std::chrono::duration<float, std::micro>(Clock::now() - frameStart).count();
+    samples[head] = pending;
+    head = (head + 1) % CAPACITY;
+    count = std::min(count + 1, CAPACITY);
+    ++total;
+}
+
+FrameProfiler::Stats FrameProfiler::stats(int column) const {
+    Stats s;
+    if (count == 0) return s;
+
+    std::array<float, CAPACITY> values;
+    for (std::size_t i = 0; i < count; ++i)
+        values[i] = samples[i][column];
+    auto end = values.begin() + count;
+
+    auto at = [&](std::size_t rank) {
+        std::nth_element(values.begin(), values.begin() + rank, end);
+        return values[rank];
+    };
+    s.max = *std::max_element(values.begin(), end);
+    s.p99 = at((count - 1) * 99 / 100);
+    s.p50 = at((count - 1) / 2);
+    return s;
+}
+
+bool FrameProfiler::writeCsv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "frame";
+    for (int c = 0; c < COLUMNS; ++c) out << ',' << phaseName(c) << "_us";
+    out << '\n';
+
+    // oldest frame first
+    const std::size_t first = (head + CAPACITY - count) % CAPACITY;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& row = samples[(first + i) % CAPACITY];
+        out << (total - count + i);
+        for (float v : row) out << ',' << v;
+        out << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+const char* FrameProfiler::phaseName(int column) {
+    static const char* names[COLUMNS] = {"events", "das", "gravity", "draw", "display", "frame"};
+    return names[column];
+}
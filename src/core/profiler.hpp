@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+enum class FramePhase {
+    Events,
+    Das,
+    Gravity,
+    Draw,
+    Display,
+    Count,
+};
+
+// Per-phase frame timings kept in a fixed-size ring buffer. Call beginFrame()
+// at the top of the loop, mark() after each phase and endFrame() at the bottom;
+// nothing allocates while recording.
+class FrameProfiler {
+public:
+    static constexpr std::size_t CAPACITY = 1024;
+    static constexpr int PHASES = static_cast<int>(FramePhase::Count);
+    // the last column holds the whole frame
+    static constexpr int COLUMNS = PHASES + 1;
+
+    struct Stats {
+        float p50 = 0.f;
+        float p99 = 0.f;
+        float max = 0.f;
+    };
+
+    void beginFrame();
+    void mark(FramePhase phase);
+    void endFrame();
+
+    std::size_t frames() const { return count; }
+    // microseconds over the frames currently in the buffer; pass PHASES for the whole frame
+    Stats stats(int column) const;
+    bool writeCsv(const std::string& path) const;
+
+    static const char* phaseName(int column);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::array<std::array<float, COLUMNS>, CAPACITY> samples = {};
+    std::array<float, COLUMNS> pending = {};
+    std::size_t head = 0;
+    std::size_t count = 0;
+    std::size_t total = 0;
+    Clock::time_point frameStart;
+    Clock::time_point lastMark;
+};
@@ -0,0 +1,76 @@
+#include "randomizer.hpp"
+#include <cstring>
+#include <utility>
+
+Randomizer::Randomizer(std::uint64_t seed, RandomizerMode mode)
+    : seed(seed), mode(mode) {
+    bagPos = static_cast<std::uint8_t>(bagSize());
+}
+
+int Randomizer::next() {
+    if (mode == RandomizerMode::Uniform) return below(7);
+
+    if (bagPos >= bagSize()) refill();
+    return bag[bagPos++];
+}
+
+void Randomizer::jump(std::uint64_t draws) {
+    counter += draws;
+    bagPos = static_cast<std::uint8_t>(bagSize());
+}
+
+Randomizer Randomizer::stream(std::uint64_t index) const {
+    Randomizer r(seed, mode);
+    r.counter = index * STREAM_STRIDE;
+    return r;
+}
+
+bool Randomizer::parseMode(const char* name, RandomizerMode& mode) {
+    if (!std::strcmp(name, "uniform")) mode = RandomizerMode::Uniform;
+    else if (!std::strcmp(name, "7bag")) mode = RandomizerMode::Bag7;
+    else if (!std::strcmp(name, "14bag")) mode = RandomizerMode::Bag14;
+    else return false;
+    return true;
+}
+
+const char* Randomizer::modeName(RandomizerMode mode) {
+    switch (mode) {
+        case RandomizerMode::Uniform: return "uniform";
+        case RandomizerMode::Bag7: return "7bag";
+        case RandomizerMode::Bag14: return "14bag";
+    }
+    return "?";
+}
+
+std::uint64_t Randomizer::draw() {
+    // SplitMix64 finalizer over seed + counter * golden gamma
+    std::uint64_t z = seed + (++counter) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Lemire's multiply-shift with rejection, free of modulo bias.
+int Randomizer::below(std::uint32_t n) {
+    while (true) {
+        const std::uint64_t m = (draw() >> 32) * n;
+        const std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low >= n || low >= (0u - n) % n) return static_cast<int>(m >> 32);
+    }
+}
+
+int Randomizer::bagSize() const {
+    switch (mode) {
+        case RandomizerMode::Bag7: return 7;
+        case RandomizerMode::Bag14: return 14;
+        default: return 0;
+    }
+}
+
+void Randomizer::refill() {
+    const int size = bagSize();
+    for (int i = 0; i < size; ++i) bag[i] = static_cast<std::uint8_t>(i % 7);
+    for (int i = size - 1; i > 0; --i)
+        std::swap(bag[i], bag[below(static_cast<std::uint32_t>(i + 1))]);
+    bagPos = 0;
+}
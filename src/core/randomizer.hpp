@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+enum class RandomizerMode : std::uint8_t {
+    Uniform,
+    Bag7,
+    Bag14,
+};
+
+// Per-game piece generator. Draws come from SplitMix64 evaluated at
+// (seed, counter), so the stream is fully determined by the seed, can skip
+// ahead in O(1) and needs no shared state between games.
+class Randomizer {
+public:
+    // draws reserved for each stream handed out by stream()
+    static constexpr std::uint64_t STREAM_STRIDE = std::uint64_t{1} << 40;
+
+    std::uint64_t seed = 0;
+    std::uint64_t counter = 0;
+    RandomizerMode mode = RandomizerMode::Uniform;
+    std::uint8_t bagPos = 0;
+    std::array<std::uint8_t, 14> bag = {};
+
+    explicit Randomizer(std::uint64_t seed = 0, RandomizerMode mode = RandomizerMode::Uniform);
+
+    int next();
+    // Skips `draws` raw generator outputs and starts a fresh bag.
+    void jump(std::uint64_t draws);
+    // Independent, reproducible stream `index` of this seed, e.g. one per worker thread.
+    Randomizer stream(std::uint64_t index) const;
+
+    static bool parseMode(const char* name, RandomizerMode& mode);
+    static const char* modeName(RandomizerMode mode);
+
+private:
+    std::uint64_t draw();
+    int below(std::uint32_t n);
+    int bagSize() const;
+    void refill();
+};
@@ -0,0 +1,178 @@
+#include "replay.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'R', 'P', 'L'};
+constexpr std::size_t FIXED_HEADER = 24;
+// ticks, events, score, lines, pieces, event bytes
+constexpr int HEADER_VARINTS = 6;
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+bool getVarint(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const std::uint8_t byte = *p++;
+        v |= std::uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void put64(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+}
+
+std::uint64_t get64(const std::uint8_t* p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+}
+
+// ---- recording -----------------------------------------------------------------
+
+void ReplayRecorder::begin(const Engine& engine) {
+    info = {};
+    info.seed = engine.randomizer.seed;
+    info.mode = engine.randomizer.mode;
+    info.previewCount = engine.previewCount;
+    events.clear();
+    lastTick = engine.ticks;
+    recording = true;
+}
+
+void ReplayRecorder::record(const Engine& engine, ReplayEvent event) {
+    if (!recording) return;
+    putVarint(events, std::uint64_t(engine.ticks - lastTick) << 3 | static_cast<std::uint8_t>(event));
+    lastTick = engine.ticks;
+    ++info.events;
+}
+
+void ReplayRecorder::finish(const Engine& engine, std::vector<std::uint8_t>& out) const {
+    out.clear();
+    for (char c : MAGIC) out.push_back(static_cast<std::uint8_t>(c));
+    out.push_back(VERSION);
+    out.push_back(static_cast<std::uint8_t>(info.mode));
+    out.push_back(static_cast<std::uint8_t>(info.previewCount));
+    out.push_back(0);
+    put64(out, info.seed);
+    put64(out, engine.boardHash);
+    putVarint(out, engine.ticks);
+    putVarint(out, info.events);
+    putVarint(out, static_cast<std::uint32_t>(engine.score));
+    putVarint(out, static_cast<std::uint32_t>(engine.lines));
+    putVarint(out, static_cast<std::uint32_t>(engine.pieces));
+    putVarint(out, events.size());
+    out.insert(out.end(), events.begin(), events.end());
+}
+
+bool ReplayRecorder::save(const char* path, const Engine& engine) const {
+    std::vector<std::uint8_t> bytes;
+    finish(engine, bytes);
+    std::FILE* out = std::fopen(path, "wb");
+    if (!out) return false;
+    const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+    return std::fclose(out) == 0 && ok;
+}
+
+// ---- reading -------------------------------------------------------------------
+
+bool ReplayView::parse(const std::uint8_t* data, std::size_t size) {
+    if (size < FIXED_HEADER || std::memcmp(data, MAGIC, 4) || data[4] != ReplayRecorder::VERSION) return false;
+    if (data[5] > static_cast<std::uint8_t>(RandomizerMode::Bag14)) return false;
+
+    header = {};
+    header.mode = static_cast<RandomizerMode>(data[5]);
+    header.previewCount = data[6];
+    header.seed = get64(data + 8);
+    header.boardHash = get64(data + 16);
+
+    const std::uint8_t* p = data + FIXED_HEADER;
+    const std::uint8_t* end = data + size;
+    std::uint64_t v[HEADER_VARINTS];
+    for (std::uint64_t& field : v)
+        if (!getVarint(p, end, field)) return false;
+    header.ticks = static_cast<std::uint32_t>(v[0]);
+    header.events = static_cast<std::uint32_t>(v[1]);
+    header.score = static_cast<int>(v[2]);
+    header.lines = static_cast<int>(v[3]);
+    header.pieces = static_cast<int>(v[4]);
+    if (v[5] > static_cast<std::uint64_t>(end - p)) return false;
+
+    begin = data;
+    events = p;
+    eventSize = static_cast<std::size_t>(v[5]);
+    total = static_cast<std::size_t>(p - data) + eventSize;
+    return true;
+}
+
+// ---- playback ------------------------------------------------------------------
+
+ReplayPlayer::ReplayPlayer(const ReplayView& replay)
+    : info(replay.info()),
+      cursor(replay.eventData()),
+      end(replay.eventData() + replay.eventBytes()),
+      remaining(replay.info().events) {
+    readNext();
+}
+
+bool ReplayPlayer::readNext() {
+    std::uint64_t v;
+    if (!remaining || !getVarint(cursor, end, v)) {
+        remaining = 0;
+        return false;
+    }
+    nextTick += static_cast<std::uint32_t>(v >> 3);
+    nextEvent = static_cast<ReplayEvent>(v & 7);
+    return true;
+}
+
+Engine ReplayPlayer::start() const {
+    return Engine(info.seed, info.mode, info.previewCount);
+}
+
+bool ReplayPlayer::step(Engine& engine) {
+    while (remaining && nextTick <= engine.ticks) {
+        if (nextEvent == ReplayEvent::Restart)
+            engine.restart();
+        else if (nextEvent < ReplayEvent::Restart)
+            engine.apply(static_cast<Input>(nextEvent));
+        --remaining;
+        readNext();
+    }
+    if (!remaining && engine.ticks >= info.ticks) return false;
+    engine.tick();
+    return true;
+}
+
+bool ReplayPlayer::run(Engine& engine) {
+    while (step(engine)) {}
+    return matches(engine);
+}
+
+bool ReplayPlayer::matches(const Engine& engine) const {
+    return engine.ticks == info.ticks && engine.score == info.score && engine.lines == info.lines &&
+           engine.pieces == info.pieces && engine.boardHash == info.boardHash;
+}
+
+bool readBinaryFile(const char* path, std::vector<std::uint8_t>& out) {
+    std::FILE* in = std::fopen(path, "rb");
+    if (!in) return false;
+    out.clear();
+    std::uint8_t buffer[1 << 16];
+    std::size_t n;
+    while ((n = std::fread(buffer, 1, sizeof buffer, in)) > 0) out.insert(out.end(), buffer, buffer + n);
+    const bool ok = !std::ferror(in);
+    std::fclose(in);
+    return ok;
+}
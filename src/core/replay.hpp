@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "engine.hpp"
+
+// Engine inputs plus restarting the game; values match Input.
+enum class ReplayEvent : std::uint8_t {
+    Left,
+    Right,
+    SoftDrop,
+    Rotate,
+    HardDrop,
+    Restart,
+};
+
+struct ReplayInfo {
+    std::uint64_t seed = 0;
+    RandomizerMode mode = RandomizerMode::Uniform;
+    int previewCount = 5;
+    // engine ticks when recording stopped
+    std::uint32_t ticks = 0;
+    std::uint32_t events = 0;
+    // final state, compared on playback
+    int score = 0;
+    int lines = 0;
+    int pieces = 0;
+    std::uint64_t boardHash = 0;
+};
+
+// Records a game from a freshly constructed Engine. Each event is stored as
+// one varint of (ticks since the previous event << 3 | event), so a typical
+// input costs one byte. Gravity needs no events: it follows from the ticks.
+//
+// File layout, little-endian:
+//   "TRPL", version, mode, previewCount, 0
+//   seed (8 bytes), final board hash (8 bytes)
+//   varints: ticks, events, score, lines, pieces, event bytes
+//   event bytes
+class ReplayRecorder {
+public:
+    static constexpr std::uint8_t VERSION = 1;
+
+    void begin(const Engine& engine);
+    // Call before the event is applied, so it is stamped with the tick it
+    // happened on.
+    void record(const Engine& engine, ReplayEvent event);
+    // Serialises the recording, stamping `engine`'s current state as the end.
+    void finish(const Engine& engine, std::vector<std::uint8_t>& out) const;
+    bool save(const char* path, const Engine& engine) const;
+
+    bool active() const { return recording; }
+
+private:
+    ReplayInfo info;
+    std::vector<std::uint8_t> events;
+    std::uint32_t lastTick = 0;
+    bool recording = false;
+};
+
+// One serialised replay in memory. Parsing only reads the header; the view
+// points into the caller's bytes, which must outlive it.
+class ReplayView {
+public:
+    // false if the bytes are not a complete replay
+    bool parse(const std::uint8_t* data, std::size_t size);
+
+    const ReplayInfo& info() const { return header; }
+    // bytes this replay occupies, header included
+    std::size_t size() const { return total; }
+    const std::uint8_t* data() const { return begin; }
+    const std::uint8_t* eventData() const { return events; }
+    std::size_t eventBytes() const { return eventSize; }
+
+private:
+    ReplayInfo header;
+    const std::uint8_t* begin = nullptr;
+    const std::uint8_t* events = nullptr;
+    std::size_t eventSize = 0;
+    std::size_t total = 0;
+};
+
+// Re-simulates a replay one tick at a time, for rendered playback, or all at
+// once with run().
+class ReplayPlayer {
+public:
+    explicit ReplayPlayer(const ReplayView& replay);
+
+    // An engine in the state the recording started from.
+    Engine start() const;
+    // Applies the events of `engine`'s current tick, then ticks it. Returns
+    // false once the recording has ended.
+    bool step(Engine& engine);
+    // Plays to the end; true if the final state matches the recording.
+    bool run(Engine& engine);
+    bool matches(const Engine& engine) const;
+
+private:
+    ReplayInfo info;
+    const std::uint8_t* cursor;
+    const std::uint8_t* end;
+    std::uint32_t remaining;
+    std::uint32_t nextTick = 0;
+    ReplayEvent nextEvent = ReplayEvent::Left;
+
+    bool readNext();
+};
+
+bool readBinaryFile(const char* path, std::vector<std::uint8_t>& out);
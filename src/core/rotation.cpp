@@ -0,0 +1,46 @@
+#include "rotation.hpp"
+#include "shapes.hpp"
+#include "tetromino.hpp"
+
+constexpr int KICK_TESTS = 5;
+
+using KickTable = std::array<std::array<Point, KICK_TESTS>, 4>;
+
+// SRS kick offsets for a clockwise turn, indexed by the state being left.
+// Pieces spawn flat side up, which is SRS state 2, so state k here is SRS
+// state (k + 2) % 4. Offsets are in board coordinates (y grows downward).
+constexpr KickTable JLSTZ_KICK_TABLE = {{
+    {{{0,0}, {1,0}, {1,-1}, {0,2}, {1,2}}},       // 0 -> 1 (SRS 2 -> L)
+    {{{0,0}, {-1,0}, {-1,1}, {0,-2}, {-1,-2}}},   // 1 -> 2 (SRS L -> 0)
+    {{{0,0}, {-1,0}, {-1,-1}, {0,2}, {-1,2}}},    // 2 -> 3 (SRS 0 -> R)
+    {{{0,0}, {1,0}, {1,1}, {0,-2}, {1,-2}}},      // 3 -> 0 (SRS R -> 2)
+}};
+
+constexpr KickTable I_KICK_TABLE = {{
+    {{{0,0}, {2,0}, {-1,0}, {2,-1}, {-1,2}}},     // 0 -> 1 (SRS 2 -> L)
+    {{{0,0}, {1,0}, {-2,0}, {1,2}, {-2,-1}}},     // 1 -> 2 (SRS L -> 0)
+    {{{0,0}, {-2,0}, {1,0}, {-2,1}, {1,-2}}},     // 2 -> 3 (SRS 0 -> R)
+    {{{0,0}, {-1,0}, {2,0}, {-1,-2}, {2,1}}},     // 3 -> 0 (SRS R -> 2)
+}};
+
+bool kickRotation(const Grid& grid, int type, int rotation, Point& pos) {
+    if (type == 0) return false;
+
+    const int to = (rotation + 1) & 3;
+    const auto& kicks = (type == 1) ? I_KICK_TABLE[rotation] : JLSTZ_KICK_TABLE[rotation];
+
+    for (const auto& offset : kicks) {
+        const Point kicked{pos.x + offset.x, pos.y + offset.y};
+        if (!collides(grid, type, to, kicked, true)) {
+            pos = kicked;
+            return true;
+        }
+    }
+    return false;
+}
+
+void applyRotation(Tetromino& piece, const Grid& grid) {
+    if (!kickRotation(grid, piece.type, piece.rotation, piece.pos)) return;
+
+    piece.rotation = (piece.rotation + 1) & 3;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "grid.hpp"
+#include "point.hpp"
+
+class Tetromino;
+
+// Tries a clockwise turn from `rotation` at `pos` with each SRS kick in order.
+// On success `pos` is moved by the kick that fit.
+bool kickRotation(const Grid& grid, int type, int rotation, Point& pos);
+void applyRotation(Tetromino& piece, const Grid& grid);
@@ -0,0 +1,152 @@
+#include "savestate.hpp"
+#include <cstring>
+#include "shapes.hpp"
+#include "zobrist.hpp"
+
+namespace {
+
+constexpr int WORDS = 8;
+static_assert(WORDS * 8 >= sizeof(SaveState::bytes));
+
+// piece coordinates are stored with this offset so they are never negative
+constexpr int COORD_BIAS = 8;
+
+class BitWriter {
+public:
+    std::array<std::uint64_t, WORDS> words = {};
+
+    void put(std::uint64_t value, int bits) {
+        words[pos >> 6] |= value << (pos & 63);
+        const int spill = (pos & 63) + bits - 64;
+        if (spill > 0) words[(pos >> 6) + 1] |= value >> (bits - spill);
+        pos += bits;
+    }
+
+private:
+    int pos = 0;
+};
+
+class BitReader {
+public:
+    explicit BitReader(const std::array<std::uint64_t, WORDS>& words) : words(words) {}
+
+    std::uint64_t get(int bits) {
+        std::uint64_t v = words[pos >> 6] >> (pos & 63);
+        const int spill = (pos & 63) + bits - 64;
+        if (spill > 0) v |= words[(pos >> 6) + 1] << (bits - spill);
+        pos += bits;
+        return bits == 64 ? v : v & ((std::uint64_t{1} << bits) - 1);
+    }
+
+private:
+    const std::array<std::uint64_t, WORDS>& words;
+    int pos = 0;
+};
+
+// nibble-per-cell color words for every 5-bit half row
+constexpr std::array<std::uint64_t, 32> NEUTRAL_HALF = [] {
+    std::array<std::uint64_t, 32> t = {};
+    for (unsigned m = 0; m < 32; ++m)
+        for (int x = 0; x < 5; ++x)
+            if (m & (1u << x)) t[m] |= std::uint64_t{SaveState::NEUTRAL_COLOR} << (4 * x);
+    return t;
+}();
+
+}
+
+SaveState saveState(const Engine& e) {
+    BitWriter w;
+    for (RowMask row : e.grid.rows) w.put(row, COLS);
+
+    w.put(static_cast<std::uint64_t>(e.current.type), 3);
+    w.put(static_cast<std::uint64_t>(e.current.pos.x + COORD_BIAS), 5);
+    w.put(static_cast<std::uint64_t>(e.current.pos.y + COORD_BIAS), 6);
+    w.put(static_cast<std::uint64_t>(e.current.rotation), 2);
+
+    w.put(e.upcoming.size(), 3);
+    for (std::size_t i = 0; i < 5; ++i)
+        w.put(i < e.upcoming.size() ? static_cast<std::uint64_t>(e.upcoming[i].type) : 0, 3);
+
+    w.put(static_cast<std::uint32_t>(e.score), 32);
+    w.put(static_cast<std::uint32_t>(e.lines), 24);
+    w.put(static_cast<std::uint32_t>(e.pieces), 24);
+    w.put(static_cast<std::uint64_t>(e.gravityCounter), 6);
+    w.put(e.gameOver, 1);
+
+    const Randomizer& r = e.randomizer;
+    w.put(r.seed, 64);
+    w.put(r.counter, 64);
+    w.put(static_cast<std::uint64_t>(r.mode), 2);
+    w.put(r.bagPos, 4);
+    for (std::uint8_t t : r.bag) w.put(t, 3);
+
+    SaveState s;
+    std::memcpy(s.bytes.data(), w.words.data(), s.bytes.size());
+    return s;
+}
+
+bool restoreState(Engine& e, const SaveState& s) {
+    std::array<std::uint64_t, WORDS> words = {};
+    std::memcpy(words.data(), s.bytes.data(), s.bytes.size());
+    BitReader r(words);
+
+    Grid grid;
+    for (int y = 0; y < ROWS; ++y) {
+        const auto row = static_cast<RowMask>(r.get(COLS));
+        grid.rows[y] = row;
+        grid.colors[y] = NEUTRAL_HALF[row & 31] | NEUTRAL_HALF[row >> 5] << 20;
+    }
+
+    const int type = static_cast<int>(r.get(3));
+    const int x = static_cast<int>(r.get(5)) - COORD_BIAS;
+    const int y = static_cast<int>(r.get(6)) - COORD_BIAS;
+    const int rotation = static_cast<int>(r.get(2));
+    const int queued = static_cast<int>(r.get(3));
+    std::array<int, 5> queue;
+    for (int& t : queue) t = static_cast<int>(r.get(3));
+
+    const auto score = static_cast<std::uint32_t>(r.get(32));
+    const auto lines = static_cast<std::uint32_t>(r.get(24));
+    const auto pieces = static_cast<std::uint32_t>(r.get(24));
+    const int gravity = static_cast<int>(r.get(6));
+    const bool gameOver = r.get(1);
+
+    Randomizer rng;
+    rng.seed = r.get(64);
+    rng.counter = r.get(64);
+    const auto mode = static_cast<std::uint8_t>(r.get(2));
+    rng.bagPos = static_cast<std::uint8_t>(r.get(4));
+    bool bagOk = true;
+    for (std::uint8_t& t : rng.bag) {
+        t = static_cast<std::uint8_t>(r.get(3));
+        bagOk = bagOk && t < PIECE_TYPES;
+    }
+
+    if (type >= PIECE_TYPES || queued < 1 || queued > 5 || mode > static_cast<std::uint8_t>(RandomizerMode::Bag14) ||
+        rng.bagPos > rng.bag.size() || !bagOk)
+        return false;
+    for (int i = 0; i < queued; ++i)
+        if (queue[i] >= PIECE_TYPES) return false;
+    // the piece must sit inside the walls and above the floor; a topped-out
+    // game is the one state where it may overlap the stack
+    if (x < -2 || x >= COLS || y < -2 || y >= ROWS) return false;
+    if (collides(gameOver ? Grid{} : grid, type, rotation, {x, y})) return false;
+    rng.mode = static_cast<RandomizerMode>(mode);
+
+    e.grid = grid;
+    e.boardHash = Zobrist::board(grid);
+    e.current = Tetromino(type);
+    e.current.rotation = rotation;
+    e.current.pos = {x, y};
+    e.upcoming.clear();
+    for (int i = 0; i < queued; ++i) e.upcoming.push_back(Tetromino(queue[i]));
+    e.previewCount = queued;
+    e.score = static_cast<int>(score);
+    e.lines = static_cast<int>(lines);
+    e.pieces = static_cast<int>(pieces);
+    e.gravityCounter = gravity;
+    e.gameOver = gameOver;
+    e.spawnTick = e.ticks;
+    e.randomizer = rng;
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "engine.hpp"
+
+// Bit-packed Engine snapshot in 63 bytes:
+//   board occupancy    20 x 10 bits
+//   current piece      type 3, x 5, y 6, rotation 2
+//   preview queue      count 3, types 5 x 3
+//   score 32, lines 24, pieces 24, gravity counter 6, game over 1
+//   randomizer         seed 64, counter 64, mode 2, bag position 4, bag 14 x 3
+// Cell colors do not fit, so restored cells take NEUTRAL_COLOR; the tick
+// counter is a session clock and is left alone.
+struct SaveState {
+    static constexpr int NEUTRAL_COLOR = 8;
+
+    std::array<std::uint8_t, 63> bytes;
+};
+
+static_assert(sizeof(SaveState) < 64);
+
+SaveState saveState(const Engine& engine);
+// False, leaving `engine` untouched, if the blob does not describe a valid state.
+bool restoreState(Engine& engine, const SaveState& state);
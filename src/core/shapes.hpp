@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include "grid.hpp"
+#include "point.hpp"
+
+constexpr int PIECE_TYPES = 7;
+// letter of each piece type, in the order of `shapes`
+constexpr char PIECE_NAMES[] = "OILJSZT";
+
+using Blocks = std::array<Point, 4>;
+
+constexpr std::array<Blocks, PIECE_TYPES> shapes = {{
+    {{{0,0}, {1,0}, {0,1}, {1,1}}},      // O
+    {{{0,0}, {1,0}, {2,0}, {3,0}}},      // I
+    {{{0,0}, {1,0}, {2,0}, {2,1}}},      // L
+    {{{0,0}, {1,0}, {2,0}, {0,1}}},      // J
+    {{{0,0}, {1,0}, {1,1}, {2,1}}},      // S
+    {{{0,1}, {1,1}, {1,0}, {2,0}}},      // Z
+    {{{0,0}, {1,0}, {2,0}, {1,1}}},      // T
+}};
+
+// Clockwise quarter turn around blocks[1]. The pivot maps onto itself, so
+// repeated turns always rotate around the same cell.
+constexpr Blocks rotateClockwise(const Blocks& blocks) {
+    const Point center = blocks[1];
+    Blocks rotated = {};
+    for (int i = 0; i < 4; ++i) {
+        const int dx = blocks[i].x - center.x;
+        const int dy = blocks[i].y - center.y;
+        rotated[i] = { -dy + center.x, dx + center.y };
+    }
+    return rotated;
+}
+
+// All four rotation states of every shape, indexed [type][rotation]. The O
+// piece never rotates, so its four entries are the spawn shape.
+constexpr std::array<std::array<Blocks, 4>, PIECE_TYPES> PIECE_STATES = [] {
+    std::array<std::array<Blocks, 4>, PIECE_TYPES> states = {};
+    for (int t = 0; t < PIECE_TYPES; ++t) {
+        states[t][0] = shapes[t];
+        for (int r = 1; r < 4; ++r)
+            states[t][r] = t == 0 ? shapes[t] : rotateClockwise(states[t][r - 1]);
+    }
+    return states;
+}();
+
+// Row-mask form of every rotation state: `rows[r]` holds the blocks of row
+// minY + r, shifted so that bit 0 is column minX.
+struct PieceMask {
+    int minX, maxX, minY, height;
+    std::array<RowMask, 4> rows;
+};
+
+constexpr std::array<std::array<PieceMask, 4>, PIECE_TYPES> PIECE_MASKS = [] {
+    std::array<std::array<PieceMask, 4>, PIECE_TYPES> masks = {};
+    for (int t = 0; t < PIECE_TYPES; ++t) {
+        for (int r = 0; r < 4; ++r) {
+            const Blocks& b = PIECE_STATES[t][r];
+            PieceMask m = {b[0].x, b[0].x, b[0].y, 0, {}};
+            int maxY = b[0].y;
+            for (const Point& p : b) {
+                m.minX = p.x < m.minX ? p.x : m.minX;
+                m.maxX = p.x > m.maxX ? p.x : m.maxX;
+                m.minY = p.y < m.minY ? p.y : m.minY;
+                maxY = p.y > maxY ? p.y : maxY;
+            }
+            m.height = maxY - m.minY + 1;
+            for (const Point& p : b)
+                m.rows[p.y - m.minY] |= static_cast<RowMask>(1u << (p.x - m.minX));
+            masks[t][r] = m;
+        }
+    }
+    return masks;
+}();
+
+// True when the piece overlaps a wall, the floor or the stack. Rows above the
+// board are free unless `ceiling` is set, which makes them solid as well.
+inline bool collides(const Grid& grid, int type, int rotation, Point pos, bool ceiling = false) {
+    const PieceMask& m = PIECE_MASKS[type][rotation];
+    const int left = pos.x + m.minX;
+    const int top = pos.y + m.minY;
+    if (left < 0 || pos.x + m.maxX >= COLS || top + m.height > ROWS) return true;
+    if (top < 0 && ceiling) return true;
+    for (int r = 0; r < m.height; ++r) {
+        const int y = top + r;
+        if (y >= 0 && (grid.rows[y] & (m.rows[r] << left))) return true;
+    }
+    return false;
+}
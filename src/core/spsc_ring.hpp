@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// Bounded single-producer, single-consumer queue. push() fails instead of
+// waiting when the ring is full, so the producer never blocks; each side
+// keeps a cached copy of the other's index and only touches the shared one
+// when the cache says the ring looks full or empty.
+template <class T, std::size_t N>
+class SpscRing {
+public:
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+    // producer side
+    bool push(const T& value) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache == N) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache == N) return false;
+        }
+        slots[t & (N - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: moves up to `max` values into `out`, returns how many
+    std::size_t pop(T* out, std::size_t max) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (tailCache == h) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (tailCache == h) return 0;
+        }
+        const std::size_t count = std::min(tailCache - h, max);
+        for (std::size_t i = 0; i < count; ++i) out[i] = slots[(h + i) & (N - 1)];
+        head.store(h + count, std::memory_order_release);
+        return count;
+    }
+
+    static constexpr std::size_t capacity() { return N; }
+
+private:
+    std::array<T, N> slots{};
+    // written by the consumer, with its cached copy of `tail` alongside
+    alignas(64) std::atomic<std::size_t> head{0};
+    std::size_t tailCache = 0;
+    // written by the producer, with its cached copy of `head` alongside
+    alignas(64) std::atomic<std::size_t> tail{0};
+    std::size_t headCache = 0;
+};
@@ -0,0 +1,86 @@
+#include "telemetry.hpp"
+#include <chrono>
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'T', 'E', 'L'};
+constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(10);
+
+void put32(std::uint8_t*& p, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) *p++ = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+void put64(std::uint8_t*& p, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) *p++ = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+}
+
+TelemetryWriter::~TelemetryWriter() {
+    close();
+}
+
+bool TelemetryWriter::open(const char* path) {
+    close();
+    file = std::fopen(path, "wb");
+    if (!file) return false;
+    const std::uint8_t header[8] = {static_cast<std::uint8_t>(MAGIC[0]), static_cast<std::uint8_t>(MAGIC[1]),
+                                    static_cast<std::uint8_t>(MAGIC[2]), static_cast<std::uint8_t>(MAGIC[3]),
+                                    VERSION, static_cast<std::uint8_t>(RECORD_BYTES), 0, 0};
+    failed = std::fwrite(header, 1, sizeof(header), file) != sizeof(header);
+    stopping = false;
+    flusher = std::thread(&TelemetryWriter::loop, this);
+    return true;
+}
+
+bool TelemetryWriter::close() {
+    if (!file) return true;
+    stopping = true;
+    flusher.join();
+    const bool ok = std::fclose(file) == 0 && !failed;
+    file = nullptr;
+    return ok;
+}
+
+void TelemetryWriter::loop() {
+    while (true) {
+        // read the flag first so events pushed before close() are still drained
+        const bool last = stopping.load(std::memory_order_acquire);
+        std::size_t count = 0;
+        while (const std::size_t n = drain()) count += n;
+        if (count && std::fflush(file) != 0) failed = true;
+        if (last) return;
+        std::this_thread::sleep_for(FLUSH_INTERVAL);
+    }
+}
+
+// Writes one batch; 0 once the ring is empty.
+std::size_t TelemetryWriter::drain() {
+    PieceEvent events[BATCH];
+    const std::size_t count = ring.pop(events, BATCH);
+    if (!count) return 0;
+
+    std::uint8_t buffer[12 + BATCH * RECORD_BYTES];
+    std::uint8_t* p = buffer;
+    put32(p, static_cast<std::uint32_t>(count));
+    put64(p, dropped.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < count; ++i) {
+        const PieceEvent& e = events[i];
+        put32(p, e.piece);
+        put32(p, e.tick);
+        put32(p, e.ticksInPlay);
+        put32(p, static_cast<std::uint32_t>(e.scoreDelta));
+        *p++ = static_cast<std::uint8_t>(e.kind);
+        *p++ = e.type;
+        *p++ = static_cast<std::uint8_t>(e.x);
+        *p++ = static_cast<std::uint8_t>(e.y);
+        *p++ = e.rotation;
+        *p++ = e.cleared;
+        *p++ = e.gameOver;
+        *p++ = 0;
+    }
+    const auto bytes = static_cast<std::size_t>(p - buffer);
+    if (std::fwrite(buffer, 1, bytes, file) != bytes) failed = true;
+    written.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include "spsc_ring.hpp"
+
+enum class PieceEventKind : std::uint8_t {
+    Spawn,
+    Lock,
+};
+
+// A piece entering play or locking. Times are engine ticks, so they match
+// replays of the same game.
+struct PieceEvent {
+    PieceEventKind kind = PieceEventKind::Spawn;
+    // pieces since restart, this one included
+    std::uint32_t piece = 0;
+    std::uint32_t tick = 0;
+    // lock only: ticks since the piece spawned
+    std::uint32_t ticksInPlay = 0;
+    std::int32_t scoreDelta = 0;
+    std::uint8_t type = 0;
+    // spawn or lock position
+    std::int8_t x = 0;
+    std::int8_t y = 0;
+    std::uint8_t rotation = 0;
+    std::uint8_t cleared = 0;
+    bool gameOver = false;
+};
+
+// Streams PieceEvents to a file without ever blocking the game thread. The
+// Engine pushes into a lock-free ring; a background thread drains it every
+// few milliseconds and appends the events in batches. Events that find the
+// ring full are dropped and counted.
+//
+// File layout, little-endian:
+//   "TTEL", version, record size, 0, 0
+//   batches: count (4 bytes), events dropped so far (8 bytes), records
+//   record: piece, tick, ticks in play, score delta (4 bytes each),
+//           kind, type, x, y, rotation, cleared, game over, 0
+class TelemetryWriter {
+public:
+    static constexpr std::uint8_t VERSION = 1;
+    static constexpr std::size_t RECORD_BYTES = 24;
+    static constexpr std::size_t RING_CAPACITY = 4096;
+    static constexpr std::size_t BATCH = 256;
+
+    TelemetryWriter() = default;
+    ~TelemetryWriter();
+
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    // Creates `path` and starts the flush thread.
+    bool open(const char* path);
+    // Drains what is left and stops the thread. False if any write failed.
+    bool close();
+
+    // Game thread only.
+    void emit(const PieceEvent& event) {
+        if (!ring.push(event)) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t droppedEvents() const { return dropped.load(std::memory_order_relaxed); }
+    std::uint64_t writtenEvents() const { return written.load(std::memory_order_relaxed); }
+
+private:
+    SpscRing<PieceEvent, RING_CAPACITY> ring;
+    std::FILE* file = nullptr;
+    std::thread flusher;
+    std::atomic<bool> stopping{false};
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<std::uint64_t> written{0};
+    bool failed = false;
+
+    void loop();
+    std::size_t drain();
+};
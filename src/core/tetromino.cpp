@@ -0,0 +1,33 @@
+#include "tetromino.hpp"
+#include "rotation.hpp"
+#include "shapes.hpp"
+
+Tetromino::Tetromino(int t) : type(t), pos({COLS / 2 - 2, 0}) {}
+
+std::array<Point, 4> Tetromino::getAbsoluteCoords(Point offset) const {
+    const std::array<Point, 4>& blocks = this->blocks();
+    std::array<Point, 4> result;
+    for (int i = 0; i < 4; ++i)
+        result[i] = {blocks[i].x + pos.x + offset.x, blocks[i].y + pos.y + offset.y};
+    return result;
+}
+
+bool Tetromino::move(Point d, const Grid& grid) {
+    if (collides(grid, type, rotation, {pos.x + d.x, pos.y + d.y}))
+        return false;
+    pos.x += d.x; pos.y += d.y;
+    return true;
+}
+
+void Tetromino::rotate(const Grid& grid) {
+    applyRotation(*this, grid);
+}
+
+bool Tetromino::isValid(const Grid& grid) const {
+    return !collides(grid, type, rotation, pos);
+}
+
+void Tetromino::lock(Grid& grid) const {
+    for (const auto& b : getAbsoluteCoords())
+        if (b.y >= 0) grid.set(b.x, b.y, type + 1);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <array>
+#include <type_traits>
+#include "point.hpp"
+#include "grid.hpp"
+#include "shapes.hpp"
+
+class Tetromino {
+public:
+    int type;
+    Point pos;
+    int rotation = 0;
+
+    Tetromino(int t = 0);
+    // cells relative to pos; looked up rather than stored, since type and
+    // rotation determine them
+    const std::array<Point, 4>& blocks() const { return PIECE_STATES[type][rotation]; }
+    std::array<Point, 4> getAbsoluteCoords(Point offset = {0, 0}) const;
+    bool move(Point d, const Grid& grid);
+    void rotate(const Grid& grid);
+    bool isValid(const Grid& grid) const;
+    void lock(Grid& grid) const;
+};
+
+static_assert(std::is_trivially_copyable_v<Tetromino>);
+static_assert(sizeof(Tetromino) <= 16, "a piece is copied into every placement list and queue slot");
@@ -0,0 +1,145 @@
+#include "thread_pool.hpp"
+
+namespace {
+
+// Participant index of the current thread in the pool it belongs to.
+thread_local const void* currentPool = nullptr;
+thread_local unsigned currentWorker = 0;
+
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; ++i) deques.push_back(std::make_unique<WorkDeque>());
+    // participant 0 is whichever outside thread calls parallelFor
+    for (unsigned i = 1; i < threads; ++i) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+bool ThreadPool::WorkDeque::push(Task* task) {
+    const std::int64_t b = bottom.load(std::memory_order_relaxed);
+    const std::int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= CAPACITY) return false;
+    buffer[b & (CAPACITY - 1)].store(task, std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+ThreadPool::Task* ThreadPool::WorkDeque::pop() {
+    const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Task* task = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // last element: race the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            task = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+ThreadPool::Task* ThreadPool::WorkDeque::steal() {
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+
+    Task* task = buffer[t & (CAPACITY - 1)].load(std::memory_order_acquire);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return task;
+}
+
+void ThreadPool::execute(Task* task, unsigned worker) {
+    task->job->body(task->job->context, task->begin, task->end, worker);
+    task->job->remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+ThreadPool::Task* ThreadPool::findWork(unsigned self) {
+    if (Task* task = deques[self]->pop()) return task;
+    const unsigned n = size();
+    for (unsigned k = 1; k < n; ++k)
+        if (Task* task = deques[(self + k) % n]->steal()) return task;
+    return nullptr;
+}
+
+void ThreadPool::run(std::size_t count, Body body, void* context) {
+    if (count == 0) return;
+
+    // outside threads share participant 0, one at a time
+    const bool member = currentPool == this;
+    std::unique_lock<std::mutex> external(externalMutex, std::defer_lock);
+    if (!member) external.lock();
+    const unsigned self = member ? currentWorker : 0;
+    const void* previousPool = currentPool;
+    const unsigned previousWorker = currentWorker;
+    currentPool = this;
+    currentWorker = self;
+
+    const std::size_t taskCount = std::min(count, MAX_TASKS);
+    std::array<Task, MAX_TASKS> tasks;
+    Job job{body, context, {taskCount}};
+
+    activeJobs.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+
+    // push in reverse so the owner pops index order while thieves take the far end
+    for (std::size_t i = taskCount; i-- > 0;) {
+        tasks[i] = {&job, count * i / taskCount, count * (i + 1) / taskCount};
+        if (!deques[self]->push(&tasks[i])) execute(&tasks[i], self);
+    }
+
+    // A nested call runs on behalf of a suspended task that still owns the
+    // worker index, so it only helps with its own tasks: stealing a sibling of
+    // the outer task would hand that sibling the same index.
+    while (job.remaining.load(std::memory_order_acquire) > 0) {
+        Task* task = member ? deques[self]->pop() : findWork(self);
+        if (member && task && task->job != &job) {
+            // ours are all taken; this one belongs to an enclosing job
+            deques[self]->push(task);
+            task = nullptr;
+        }
+        if (task) execute(task, self);
+        else std::this_thread::yield();
+    }
+
+    activeJobs.fetch_sub(1, std::memory_order_acq_rel);
+    currentPool = previousPool;
+    currentWorker = previousWorker;
+}
+
+void ThreadPool::workerLoop(unsigned self) {
+    currentPool = this;
+    currentWorker = self;
+    while (true) {
+        if (Task* task = findWork(self)) {
+            execute(task, self);
+            continue;
+        }
+        if (activeJobs.load(std::memory_order_acquire) > 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&] { return stopping || activeJobs.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
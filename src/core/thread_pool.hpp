@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing scheduler. Every participant owns a fixed-size Chase-Lev
+// deque: it pushes and pops at the bottom, idle participants steal from the
+// top without locks. parallelFor() splits a loop into tasks on the calling
+// thread's deque and helps run them until the loop is done, so it can be
+// nested inside a task; a nested call only helps with its own tasks.
+class ThreadPool {
+public:
+    // `threads` counts the calling thread; 0 picks hardware_concurrency().
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(deques.size()); }
+
+    // Calls fn(index, worker) for every index in [0, count). `worker` is in
+    // [0, size()) and unique among the calls of this loop running at once, so
+    // it can select per-thread scratch buffers. A loop nested inside a task
+    // may run some of its calls with the index of the task that started it,
+    // while that task is suspended, so inner and outer loops need separate
+    // scratch. Callers that need a deterministic result should write into
+    // slot `index` and combine in index order.
+    template <class F>
+    void parallelFor(std::size_t count, F&& fn) {
+        auto body = [](void* context, std::size_t begin, std::size_t end, unsigned worker) {
+            F& f = *static_cast<std::remove_reference_t<F>*>(context);
+            for (std::size_t i = begin; i < end; ++i) f(i, worker);
+        };
+        run(count, body, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+private:
+    using Body = void (*)(void*, std::size_t, std::size_t, unsigned);
+
+    struct Job {
+        Body body;
+        void* context;
+        std::atomic<std::size_t> remaining;
+    };
+
+    struct Task {
+        Job* job;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    class WorkDeque {
+    public:
+        static constexpr std::int64_t CAPACITY = 1024;
+
+        bool push(Task* task);
+        Task* pop();
+        Task* steal();
+
+    private:
+        alignas(64) std::atomic<std::int64_t> top{0};
+        alignas(64) std::atomic<std::int64_t> bottom{0};
+        std::array<std::atomic<Task*>, CAPACITY> buffer{};
+    };
+
+    static constexpr std::size_t MAX_TASKS = 256;
+
+    std::vector<std::unique_ptr<WorkDeque>> deques;
+    std::vector<std::thread> workers;
+    std::mutex externalMutex;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> activeJobs{0};
+    std::atomic<bool> stopping{false};
+
+    void run(std::size_t count, Body body, void* context);
+    void workerLoop(unsigned self);
+    Task* findWork(unsigned self);
+    static void execute(Task* task, unsigned worker);
+};
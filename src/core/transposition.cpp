@@ -0,0 +1,141 @@
+#include "transposition.hpp"
+#include <bit>
+#include <cstring>
+#include <limits>
+
+// data layout: value bits | depth << 32 | generation << 40 | OCCUPIED
+// | HAS_MOVE | x + 4 << 50 | y + 4 << 54 | rotation << 59.
+// A zero word marks an empty slot; the OCCUPIED bit keeps a stored entry
+// nonzero whatever its value and depth. The move fields cover the move
+// generator's whole (x, y) range.
+
+namespace {
+
+constexpr std::uint64_t OCCUPIED = std::uint64_t{1} << 48;
+constexpr std::uint64_t HAS_MOVE = std::uint64_t{1} << 49;
+constexpr int MOVE_SHIFT = 50;
+constexpr int MOVE_BIAS = 4;
+
+void bump(std::atomic<std::uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+}
+
+TranspositionTable::TranspositionTable(std::size_t megabytes, unsigned workers) : workers(workers ? workers : 1) {
+    const std::size_t wanted = megabytes * 1024 * 1024 / sizeof(Bucket);
+    const std::size_t count = wanted ? std::bit_floor(wanted) : 1;
+    buckets = std::make_unique<Bucket[]>(count);
+    mask = count - 1;
+    counters = std::make_unique<Counters[]>(this->workers);
+    clear();
+}
+
+std::uint64_t TranspositionTable::pack(const TTEntry& entry, std::uint8_t generation) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &entry.value, sizeof bits);
+    std::uint64_t data = bits | std::uint64_t(entry.depth) << 32 | std::uint64_t(generation) << 40 | OCCUPIED;
+    if (entry.hasMove) {
+        const std::uint64_t move = std::uint64_t((entry.moveX + MOVE_BIAS) & 15) |
+                                   std::uint64_t((entry.moveY + MOVE_BIAS) & 31) << 4 |
+                                   std::uint64_t(entry.moveRotation & 3) << 9;
+        data |= HAS_MOVE | move << MOVE_SHIFT;
+    }
+    return data;
+}
+
+TTEntry TranspositionTable::unpack(std::uint64_t data) {
+    TTEntry e;
+    const auto bits = static_cast<std::uint32_t>(data);
+    std::memcpy(&e.value, &bits, sizeof bits);
+    e.depth = static_cast<std::uint8_t>(data >> 32);
+    e.hasMove = data & HAS_MOVE;
+    if (e.hasMove) {
+        const std::uint64_t move = data >> MOVE_SHIFT;
+        e.moveX = static_cast<std::int8_t>(int(move & 15) - MOVE_BIAS);
+        e.moveY = static_cast<std::int8_t>(int(move >> 4 & 31) - MOVE_BIAS);
+        e.moveRotation = static_cast<std::uint8_t>(move >> 9 & 3);
+    }
+    return e;
+}
+
+bool TranspositionTable::probe(std::uint64_t key, TTEntry& out, unsigned worker) {
+    Bucket& b = buckets[key & mask];
+    for (Slot& s : b.slots) {
+        const std::uint64_t data = s.data.load(std::memory_order_relaxed);
+        if (data && (s.check.load(std::memory_order_relaxed) ^ data) == key) {
+            out = unpack(data);
+            bump(counters[worker].hits);
+            return true;
+        }
+    }
+    bump(counters[worker].misses);
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, const TTEntry& entry, unsigned worker) {
+    Bucket& b = buckets[key & mask];
+
+    // same position, else an empty slot, else the oldest and shallowest entry
+    Slot* victim = &b.slots[0];
+    int victimRank = std::numeric_limits<int>::max();
+    bool evicts = false;
+    for (Slot& s : b.slots) {
+        const std::uint64_t data = s.data.load(std::memory_order_relaxed);
+        if (data && (s.check.load(std::memory_order_relaxed) ^ data) == key) {
+            victim = &s;
+            evicts = false;
+            break;
+        }
+        int rank = std::numeric_limits<int>::min();
+        if (data) {
+            const auto age = static_cast<std::uint8_t>(generation - static_cast<std::uint8_t>(data >> 40));
+            rank = static_cast<int>(data >> 32 & 0xFF) - age * 256;
+        }
+        if (rank < victimRank) {
+            victim = &s;
+            victimRank = rank;
+            evicts = data != 0;
+        }
+    }
+
+    const std::uint64_t data = pack(entry, generation);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+    bump(counters[worker].stores);
+    if (evicts) bump(counters[worker].replacements);
+}
+
+void TranspositionTable::newSearch() {
+    ++generation;
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i <= mask; ++i) {
+        for (Slot& s : buckets[i].slots) {
+            s.check.store(0, std::memory_order_relaxed);
+            s.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+TTStats TranspositionTable::stats() const {
+    TTStats total;
+    for (unsigned w = 0; w < workers; ++w) {
+        total.hits += counters[w].hits.load(std::memory_order_relaxed);
+        total.misses += counters[w].misses.load(std::memory_order_relaxed);
+        total.stores += counters[w].stores.load(std::memory_order_relaxed);
+        total.replacements += counters[w].replacements.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void TranspositionTable::resetStats() {
+    for (unsigned w = 0; w < workers; ++w) {
+        counters[w].hits = 0;
+        counters[w].misses = 0;
+        counters[w].stores = 0;
+        counters[w].replacements = 0;
+    }
+}
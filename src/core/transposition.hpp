@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct TTEntry {
+    float value = 0.f;
+    // search depth below this position that produced `value`, 0 for a
+    // static evaluation; deeper entries are kept longer
+    std::uint8_t depth = 0;
+    // best placement of the current piece found from this position, where
+    // it locks; static evaluations have none
+    bool hasMove = false;
+    std::int8_t moveX = 0;
+    std::int8_t moveY = 0;
+    std::uint8_t moveRotation = 0;
+};
+
+struct TTStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t stores = 0;
+    // stores that evicted a different position
+    std::uint64_t replacements = 0;
+};
+
+// Fixed-size hash table keyed by Zobrist hashes. Buckets are one cache line of
+// four entries. Probes and stores never lock: each entry keeps `key ^ data`
+// next to `data`, so an entry torn by two racing writers fails verification
+// and reads as a miss instead of returning a mixed value. Statistics are
+// counted per worker, so callers on different threads share no counter.
+class TranspositionTable {
+public:
+    static constexpr int WAYS = 4;
+
+    // Rounded down to a power-of-two bucket count, at least one bucket.
+    // `workers` is the number of distinct worker indices callers pass.
+    explicit TranspositionTable(std::size_t megabytes, unsigned workers = 1);
+
+    // `worker` selects the statistics block; no two threads may use the same
+    // one at once
+    bool probe(std::uint64_t key, TTEntry& out, unsigned worker = 0);
+    void store(std::uint64_t key, const TTEntry& entry, unsigned worker = 0);
+
+    // Starts a new search generation; entries from older generations are
+    // replaced first.
+    void newSearch();
+    void clear();
+
+    std::size_t bucketCount() const { return mask + 1; }
+    std::size_t bytes() const { return bucketCount() * sizeof(Bucket); }
+    // summed over every worker
+    TTStats stats() const;
+    void resetStats();
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        std::array<Slot, WAYS> slots;
+    };
+    static_assert(sizeof(Bucket) == 64);
+
+    // Written only by its own worker, so a count is a plain load and store;
+    // the atomics just let stats() read while a search runs.
+    struct alignas(64) Counters {
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::uint64_t> stores{0};
+        std::atomic<std::uint64_t> replacements{0};
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    std::size_t mask = 0;
+    std::uint8_t generation = 0;
+
+    std::unique_ptr<Counters[]> counters;
+    unsigned workers = 1;
+
+    static std::uint64_t pack(const TTEntry& entry, std::uint8_t generation);
+    static TTEntry unpack(std::uint64_t data);
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// Single-writer, single-reader handoff of the latest value. The writer fills
+// back() and publish()es it; the reader calls update() and reads front().
+// Neither side blocks or allocates, and the reader only ever sees the most
+// recently published value.
+template <class T>
+class TripleBuffer {
+public:
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    T& back() { return slots[backIndex].value; }
+
+    void publish() {
+        backIndex = state.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // true if a value was published since the last update()
+    bool update() {
+        if (!(state.load(std::memory_order_relaxed) & FRESH)) return false;
+        frontIndex = state.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& front() const { return slots[frontIndex].value; }
+
+private:
+    static constexpr std::uint8_t INDEX = 3;
+    static constexpr std::uint8_t FRESH = 4;
+
+    // one slot per cache line so the two sides never share one
+    struct alignas(64) Slot {
+        T value{};
+    };
+
+    std::array<Slot, 3> slots{};
+    // index of the middle slot, plus FRESH once the writer has swapped it in
+    std::atomic<std::uint8_t> state{1};
+    std::uint8_t backIndex = 0;
+    std::uint8_t frontIndex = 2;
+};
@@ -0,0 +1,93 @@
+#include "zobrist.hpp"
+
+namespace {
+
+constexpr std::uint64_t splitmix(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+constexpr int HALF = COLS / 2;
+
+struct Keys {
+    // every subset of each half-row, so a row hashes with two lookups
+    std::array<std::array<std::uint64_t, 1 << HALF>, ROWS> low = {};
+    std::array<std::array<std::uint64_t, 1 << HALF>, ROWS> high = {};
+    std::array<std::array<std::uint64_t, 8>, Zobrist::QUEUE_SLOTS> queue = {};
+    std::array<std::uint64_t, 64> lines = {};
+};
+
+constexpr Keys KEYS = [] {
+    Keys k;
+    std::uint64_t state = 0x7E7215ull;
+    std::array<std::array<std::uint64_t, COLS>, ROWS> cell = {};
+    for (auto& r : cell)
+        for (auto& c : r) c = splitmix(state);
+    for (int y = 0; y < ROWS; ++y) {
+        for (unsigned m = 0; m < (1u << HALF); ++m) {
+            for (int x = 0; x < HALF; ++x) {
+                if (m & (1u << x)) {
+                    k.low[y][m] ^= cell[y][x];
+                    k.high[y][m] ^= cell[y][x + HALF];
+                }
+            }
+        }
+    }
+    for (auto& slot : k.queue)
+        for (auto& t : slot) t = splitmix(state);
+    for (auto& l : k.lines) l = splitmix(state);
+    return k;
+}();
+
+}
+
+std::uint64_t Zobrist::row(int y, RowMask mask) {
+    return KEYS.low[y][mask & ((1u << HALF) - 1)] ^ KEYS.high[y][mask >> HALF];
+}
+
+std::uint64_t Zobrist::rows(const Grid& grid, int first, int last) {
+    std::uint64_t h = 0;
+    for (int y = first; y < last; ++y) h ^= row(y, grid.rows[y]);
+    return h;
+}
+
+std::uint64_t Zobrist::board(const Grid& grid) {
+    return rows(grid, 0, ROWS);
+}
+
+std::uint64_t Zobrist::piece(const Tetromino& piece) {
+    std::uint64_t h = 0;
+    for (const auto& c : piece.getAbsoluteCoords())
+        if (c.y >= 0) h ^= row(c.y, static_cast<RowMask>(1u << c.x));
+    return h;
+}
+
+std::uint64_t Zobrist::queue(const int* types, int count) {
+    std::uint64_t h = 0;
+    for (int i = 0; i < count && i < QUEUE_SLOTS; ++i) h ^= KEYS.queue[i][types[i]];
+    return h;
+}
+
+std::uint64_t Zobrist::lines(int cleared) {
+    return KEYS.lines[cleared & 63];
+}
+
+std::uint64_t Zobrist::place(Grid& grid, const Tetromino& piece, std::uint64_t hash, int& cleared) {
+    hash ^= Zobrist::piece(piece);
+    piece.lock(grid);
+
+    int lowest = -1;
+    for (const auto& c : piece.getAbsoluteCoords())
+        if (c.y >= 0 && grid.isFull(c.y) && c.y > lowest) lowest = c.y;
+    if (lowest < 0) {
+        cleared = 0;
+        return hash;
+    }
+
+    // rows below the lowest full row do not move
+    hash ^= rows(grid, 0, lowest + 1);
+    cleared = grid.clearFullRows();
+    return hash ^ rows(grid, 0, lowest + 1);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "grid.hpp"
+#include "tetromino.hpp"
+
+// 64-bit Zobrist keys for boards and piece queues. A board hashes the occupied
+// cells only, so boards that differ in color alone collide on purpose.
+struct Zobrist {
+    // queue slot 0 is the active piece, slots 1.. are the previews
+    static constexpr int QUEUE_SLOTS = 6;
+
+    static std::uint64_t row(int y, RowMask mask);
+    // rows [first, last)
+    static std::uint64_t rows(const Grid& grid, int first, int last);
+    static std::uint64_t board(const Grid& grid);
+    // cells `piece` would fill when locked at its current position
+    static std::uint64_t piece(const Tetromino& piece);
+    static std::uint64_t queue(const int* types, int count);
+    static std::uint64_t lines(int cleared);
+
+    // Locks `piece`, clears full rows and returns the updated board hash.
+    // Only the rows at or above the lowest cleared row are rehashed.
+    static std::uint64_t place(Grid& grid, const Tetromino& piece, std::uint64_t hash, int& cleared);
+};
@@ -1,6 +1,7 @@
 #include "game.hpp"
 #include "arial_font.h"
-#include <sstream>
+#include <string>
+#include <cstdio>
 #include <iostream>
 #include <algorithm>
 #include <cmath>
@@ -8,12 +9,18 @@
 constexpr int BLOCK_SIZE = 60;
 constexpr int LOGICAL_W = COLS * BLOCK_SIZE + 300;
 constexpr int LOGICAL_H = ROWS * BLOCK_SIZE;
+constexpr const char* SAVE_PATH = "savestate.bin";
 
-Game::Game()
-    : current(rand() % 7),
+Game::Game(const GameOptions& options)
+    : engine(options.seed, options.randomizerMode),
+      botInputDelay(std::max(options.botInputDelay, 0.f)),
+      recordPath(options.recordPath),
+      replaySpeed(options.replaySpeed > 0.f ? options.replaySpeed : 1.f),
       scoreText(font, "", 20),
+      nextText(font, "Next", 20),
       gameOverText(font, "Game Over!", 30),
       pausedText(font, "Paused", 30),
+      restartText(font, "Press R to Restart", 20),
       helpText(font, "Controls:\n"
         "A: Left move\n"
         "D: Right move\n"
@@ -22,7 +29,13 @@ Game::Game()
         "Space: Hard drop\n"
         "P: Pause\n"
         "R: Restart\n"
-        "Esc: Quit", 18) {
+        "B: Bot\n"
+        "F5: Save / F9: Load\n"
+        "F3: Profiler\n"
+        "Esc: Quit", 18),
+      profilerText(font, "", 14),
+      modeText(font, "Autoplay", 20),
+      profilePath(options.profilePath) {
 
     if (!font.openFromMemory(arial_ttf, arial_ttf_len)) {
         std::cerr << "Failed to load font" << std::endl;
@@ -31,22 +44,47 @@ Game::Game()
 
     scoreText.setPosition({10.f, 10.f});
 
+    nextText.setPosition({COLS * BLOCK_SIZE + 20.f, 30.f});
+
     gameOverText.setFillColor(sf::Color::Red);
     gameOverText.setPosition({COLS * BLOCK_SIZE / 2.f - 70.f, ROWS * BLOCK_SIZE / 2.f - 20.f});
 
     pausedText.setFillColor(sf::Color::Yellow);
     pausedText.setPosition({COLS * BLOCK_SIZE / 2.f - 50.f, ROWS * BLOCK_SIZE / 2.f - 20.f});
 
+    restartText.setFillColor(sf::Color::White);
+    restartText.setPosition({COLS * BLOCK_SIZE / 2.f - 70.f, ROWS * BLOCK_SIZE / 2.f + 20.f});
+
     helpText.setFillColor(sf::Color::White);
 
-    previewCount = std::clamp(previewCount, 1, 5);
-    for (int i = 0; i < previewCount; ++i) {
-        upcoming.push_back(Tetromino(rand() % 7));
-    }
+    profilerText.setFillColor(sf::Color::Green);
+    profilerText.setPosition({10.f, 40.f});
 
-    current = upcoming.front();
-    upcoming.pop_front();
-    upcoming.push_back(Tetromino(rand() % 7));
+    modeText.setFillColor(sf::Color::Cyan);
+    modeText.setPosition({COLS * BLOCK_SIZE - 130.f, 10.f});
+
+    if (!options.replayPath.empty()) {
+        ReplayView view;
+        if (!readBinaryFile(options.replayPath.c_str(), replayBytes) || !view.parse(replayBytes.data(), replayBytes.size())) {
+            std::cerr << "Failed to read replay " << options.replayPath << std::endl;
+            std::exit(1);
+        }
+        player = std::make_unique<ReplayPlayer>(view);
+        engine = player->start();
+        char label[32];
+        std::snprintf(label, sizeof(label), "Replay x%g", replaySpeed);
+        modeText.setString(label);
+    } else if (!recordPath.empty()) {
+        recorder.begin(engine);
+    }
+    if (!options.telemetryPath.empty()) {
+        telemetry = std::make_unique<TelemetryWriter>();
+        if (!telemetry->open(options.telemetryPath.c_str())) {
+            std::cerr << "Failed to open " << options.telemetryPath << std::endl;
+            std::exit(1);
+        }
+        engine.telemetry = telemetry.get();
+    }
 
     sf::VideoMode mode({ static_cast<unsigned int>(LOGICAL_W), static_cast<unsigned int>(LOGICAL_H) });
     window.create(mode, "Tetris");
@@ -62,51 +100,72 @@ Game::Game()
 
     updateViewportPixels(curSize.x, curSize.y);
     updateUIFromViewport();
+    buildStaticLayers();
+    if (!player) setAutoplay(options.autoplay);
 }
 
 void Game::run() {
     sf::Clock clock;
-    float delay = 0.5f;
-    float timer = 0;
     while (window.isOpen()) {
         float time = clock.restart().asSeconds();
-        timer += time;
+        profiler.beginFrame();
 
         handleEvents();
-        if (!paused && !gameOver) {
-            handleDAS(time);
-            if (timer > delay) {
-                timer = 0;
-                if (!current.move({0, 1}, grid)) lockAndNext();
-            }
+        profiler.mark(FramePhase::Events);
+        if (player) {
+            if (!paused) playReplay(time);
+            profiler.mark(FramePhase::Das);
+            profiler.mark(FramePhase::Gravity);
+        } else if (!paused && !engine.gameOver) {
+            if (botEnabled)
+                driveBot(time);
+            else
+                handleDAS(time);
+            profiler.mark(FramePhase::Das);
+            advanceTicks(time);
+            profiler.mark(FramePhase::Gravity);
         }
         draw();
+        profiler.mark(FramePhase::Draw);
+        window.display();
+        profiler.mark(FramePhase::Display);
+
+        profiler.endFrame();
+    }
+
+    if (!profilePath.empty() && !profiler.writeCsv(profilePath))
+        std::cerr << "Failed to write " << profilePath << std::endl;
+    if (recorder.active() && !recorder.save(recordPath.c_str(), engine))
+        std::cerr << "Failed to write " << recordPath << std::endl;
+    if (telemetry) {
+        if (!telemetry->close()) std::cerr << "Failed to write telemetry" << std::endl;
+        if (telemetry->droppedEvents())
+            std::cerr << "Telemetry dropped " << telemetry->droppedEvents() << " events" << std::endl;
     }
 }
 
 void Game::handleKeyPress(sf::Keyboard::Scancode key) {
     switch (key) {
         case sf::Keyboard::Scancode::A:
-            current.move({-1, 0}, grid);
+            sendInput(Input::Left);
             moveHoldKey = key;
             moveHoldTimer = -dasDelay;
             break;
         case sf::Keyboard::Scancode::D:
-            current.move({1, 0}, grid);
+            sendInput(Input::Right);
             moveHoldKey = key;
             moveHoldTimer = -dasDelay;
             break;
         case sf::Keyboard::Scancode::S:
-            current.move({0, 1}, grid);
+            sendInput(Input::SoftDrop);
             moveHoldKey = key;
             moveHoldTimer = -dasDelay;
             break;
         case sf::Keyboard::Scancode::W:
-            current.rotate(grid);
+            sendInput(Input::Rotate);
             break;
         case sf::Keyboard::Scancode::Space:
-            while (current.move({0, 1}, grid)) {}
-            lockAndNext();
+            sendInput(Input::HardDrop);
             break;
         default:
             break;
@@ -136,12 +195,31 @@ void Game::handleEvents() {
                 window.close();
                 continue;
             }
+            if (key == sf::Keyboard::Scancode::F3) {
+                showProfiler = !showProfiler;
+                continue;
+            }
+            // a replay only takes pause, quit and the profiler
+            if (player) continue;
+
             if (key == sf::Keyboard::Scancode::R) {
                 restartGame();
                 continue;
             }
+            if (key == sf::Keyboard::Scancode::B) {
+                setAutoplay(!botEnabled);
+                continue;
+            }
+            if (key == sf::Keyboard::Scancode::F5) {
+                saveGame();
+                continue;
+            }
+            if (key == sf::Keyboard::Scancode::F9) {
+                loadGame();
+                continue;
+            }
 
-            if (paused || gameOver) continue;
+            if (paused || engine.gameOver || botEnabled) continue;
 
             handleKeyPress(key);
         }
@@ -155,139 +233,118 @@ void Game::handleEvents() {
     }
 }
 
-void Game::lockAndNext() {
-    for (auto& b : current.getAbsoluteCoords())
-        if (b.y >= 0) grid[b.y][b.x] = current.type + 1;
-
-    int lines = clearLines();
-    score += lines * 100;
-    if (lines == 3) score += 100;
-    if (lines == 4) score += 200;
-
-    current = upcoming.front();
-    upcoming.pop_front();
-    upcoming.push_back(Tetromino(rand() % 7));
-
-    if (!current.isValid(grid)) gameOver = true;
-}
-
-int Game::clearLines() {
-    int cleared = 0;
-    for (int y = ROWS - 1; y >= 0; --y) {
-        bool full = true;
-        for (int x = 0; x < COLS; ++x)
-            if (!grid[y][x]) { full = false; break; }
-        if (full) {
-            for (int row = y; row > 0; --row)
-                grid[row] = grid[row - 1];
-            grid[0].fill(0);
-            ++cleared; ++y;
-        }
-    }
-    return cleared;
-}
-
 void Game::draw() {
     window.clear(sf::Color::Black);
     window.setView(gameView);
+
+    // every block of the frame goes into one vertex array and one draw call
+    blockBatch.clear();
     drawFixedBlocks();
-    drawGridLines();
     drawGhost();
     drawCurrent();
     drawPreviews();
+    window.draw(blockBatch);
+
+    drawGridLines();
     drawScore();
     if (paused) window.draw(pausedText);
-    if (gameOver) window.draw(gameOverText);
+    if (engine.gameOver) window.draw(gameOverText);
 
     window.draw(helpText);
 
-    if (gameOver || paused) {
-        sf::Text restartText(font, "Press R to Restart", 20);
-        restartText.setFillColor(sf::Color::White);
-        restartText.setPosition({COLS * BLOCK_SIZE / 2.f - 70.f, ROWS * BLOCK_SIZE / 2.f + 20.f});
-        window.draw(restartText);
-    }
+    if (engine.gameOver || paused) window.draw(restartText);
 
-    window.display();
+    if (botEnabled || player) window.draw(modeText);
+    if (showProfiler) drawProfiler();
 }
 
 void Game::drawFixedBlocks() {
-    for (int y = 0; y < ROWS; ++y)
+    const Grid& grid = engine.grid;
+    for (int y = 0; y < ROWS; ++y) {
+        if (!grid.rows[y]) continue;
         for (int x = 0; x < COLS; ++x)
-            if (grid[y][x]) drawBlock(x, y, getColor(grid[y][x]));
+            if (grid.occupied(x, y)) drawBlock(x, y, getColor(grid.color(x, y)));
+    }
 }
 
 void Game::drawBlock(int x, int y, sf::Color color, Point offset) {
-    sf::RectangleShape rect;
-    rect.setSize({BLOCK_SIZE - 2.f, BLOCK_SIZE - 2.f});
-    rect.setPosition({
-        static_cast<float>(x * BLOCK_SIZE + 1 + offset.x),
-        static_cast<float>(y * BLOCK_SIZE + 1 + offset.y)
-    });
-    rect.setFillColor(color);
-    window.draw(rect);
+    drawBlockAbsolute(x * BLOCK_SIZE + 1 + offset.x, y * BLOCK_SIZE + 1 + offset.y, color);
 }
 
 void Game::drawBlockAbsolute(int px, int py, sf::Color color) {
-    sf::RectangleShape rect;
-    rect.setSize({BLOCK_SIZE - 2.f, BLOCK_SIZE - 2.f});
-    rect.setPosition({static_cast<float>(px), static_cast<float>(py)});
-    rect.setFillColor(color);
-    window.draw(rect);
+    const float left = static_cast<float>(px);
+    const float top = static_cast<float>(py);
+    const float right = left + BLOCK_SIZE - 2.f;
+    const float bottom = top + BLOCK_SIZE - 2.f;
+
+    blockBatch.append(sf::Vertex{ {left, top}, color });
+    blockBatch.append(sf::Vertex{ {right, top}, color });
+    blockBatch.append(sf::Vertex{ {left, bottom}, color });
+    blockBatch.append(sf::Vertex{ {left, bottom}, color });
+    blockBatch.append(sf::Vertex{ {right, top}, color });
+    blockBatch.append(sf::Vertex{ {right, bottom}, color });
 }
 
-void Game::drawGridLines() {
+void Game::buildStaticLayers() {
     const float W = static_cast<float>(COLS * BLOCK_SIZE);
     const float H = static_cast<float>(ROWS * BLOCK_SIZE);
 
-    sf::VertexArray lines(sf::PrimitiveType::Lines);
+    gridLines.clear();
     const sf::Color c(50, 50, 50);
 
     for (int x = 0; x <= COLS; ++x) {
         float px = static_cast<float>(x * BLOCK_SIZE) + 0.5f;
-        lines.append(sf::Vertex{ {px, 0.5f}, c });
-        lines.append(sf::Vertex{ {px, H - 0.5f}, c });
+        gridLines.append(sf::Vertex{ {px, 0.5f}, c });
+        gridLines.append(sf::Vertex{ {px, H - 0.5f}, c });
     }
 
     for (int y = 0; y <= ROWS; ++y) {
         float py = static_cast<float>(y * BLOCK_SIZE) + 0.5f;
-        lines.append(sf::Vertex{ {0.5f, py}, c });
-        lines.append(sf::Vertex{ {W - 0.5f, py}, c });
+        gridLines.append(sf::Vertex{ {0.5f, py}, c });
+        gridLines.append(sf::Vertex{ {W - 0.5f, py}, c });
     }
 
-    lines.append(sf::Vertex{ {0.5f, H - 0.5f}, c });
-    lines.append(sf::Vertex{ {W - 0.5f, H - 0.5f}, c });
+    gridLines.append(sf::Vertex{ {0.5f, H - 0.5f}, c });
+    gridLines.append(sf::Vertex{ {W - 0.5f, H - 0.5f}, c });
 
-    window.draw(lines);
+    // upload once; drawGridLines falls back to the vertex array without VBO support
+    gridLinesOnGpu = sf::VertexBuffer::isAvailable()
+        && gridLinesBuffer.create(gridLines.getVertexCount())
+        && gridLinesBuffer.update(&gridLines[0]);
+}
+
+void Game::drawGridLines() {
+    if (gridLinesOnGpu)
+        window.draw(gridLinesBuffer);
+    else
+        window.draw(gridLines);
 }
 
 void Game::drawGhost() {
-    Tetromino ghost = current;
-    while (ghost.move({0, 1}, grid)) {}
+    Tetromino ghost = engine.current;
+    while (ghost.move({0, 1}, engine.grid)) {}
     for (auto& b : ghost.getAbsoluteCoords()) {
-        sf::Color ghostColor = getColor(current.type + 1);
+        sf::Color ghostColor = getColor(engine.current.type + 1);
         ghostColor.a = 80;
         drawBlock(b.x, b.y, ghostColor);
     }
 }
 
 void Game::drawCurrent() {
-    for (auto& b : current.getAbsoluteCoords())
-        drawBlock(b.x, b.y, getColor(current.type + 1));
+    for (auto& b : engine.current.getAbsoluteCoords())
+        drawBlock(b.x, b.y, getColor(engine.current.type + 1));
 }
 
 void Game::drawPreviews() {
     int baseX = COLS * BLOCK_SIZE + 20;
     int baseY = 60;
 
-    sf::Text label(font, "Next", 20);
-    label.setPosition({static_cast<float>(baseX), static_cast<float>(baseY - 30)});
-    window.draw(label);
+    window.draw(nextText);
 
-    for (int i = 0; i < previewCount; ++i) {
-        const Tetromino& t = upcoming[i];
+    for (int i = 0; i < engine.previewCount; ++i) {
+        const Tetromino& t = engine.upcoming[i];
         int offsetY = baseY + i * (BLOCK_SIZE * 3 + 10);
-        for (const auto& b : t.blocks) {
+        for (const auto& b : t.blocks()) {
             int px = b.x * BLOCK_SIZE + baseX;
             int py = b.y * BLOCK_SIZE + offsetY;
             drawBlockAbsolute(px, py, getColor(t.type + 1));
@@ -296,25 +353,144 @@ void Game::drawPreviews() {
 }
 
 void Game::drawScore() {
-    std::stringstream ss;
-    ss << "Score: " << score;
-    scoreText.setString(ss.str());
+    // score only changes in lockAndNext, so the glyphs are re-laid out once per lock at most
+    if (engine.score != shownScore) {
+        shownScore = engine.score;
+        scoreText.setString("Score: " + std::to_string(shownScore));
+    }
     window.draw(scoreText);
 }
 
+void Game::drawProfiler() {
+    // refresh a few times per second so the HUD itself stays off the profile
+    if (profilerRefresh.getElapsedTime().asSeconds() > 0.25f) {
+        profilerRefresh.restart();
+
+        std::string hud = "phase     p50    p99    max (us)\n";
+        char line[64];
+        for (int c = 0; c < FrameProfiler::COLUMNS; ++c) {
+            const auto st = profiler.stats(c);
+            std::snprintf(line, sizeof(line), "%-8s %6.0f %6.0f %6.0f\n",
+                          FrameProfiler::phaseName(c), st.p50, st.p99, st.max);
+            hud += line;
+        }
+        profilerText.setString(hud);
+    }
+    window.draw(profilerText);
+}
+
 void Game::handleDAS(float dt) {
     if (moveHoldKey == sf::Keyboard::Scancode::A || moveHoldKey == sf::Keyboard::Scancode::D) {
         moveHoldTimer += dt;
         while (moveHoldTimer >= dasRepeat) {
             if (moveHoldKey == sf::Keyboard::Scancode::A)
-                current.move({-1, 0}, grid);
+                sendInput(Input::Left);
             else
-                current.move({1, 0}, grid);
+                sendInput(Input::Right);
             moveHoldTimer -= dasRepeat;
         }
     }
 }
 
+void Game::sendInput(Input input) {
+    recorder.record(engine, static_cast<ReplayEvent>(input));
+    engine.apply(input);
+}
+
+void Game::advanceTicks(float dt) {
+    const float step = 1.f / Engine::TICK_RATE;
+    // after a long stall, drop the backlog rather than dropping pieces at once
+    tickAccumulator = std::min(tickAccumulator + dt, 0.25f);
+    while (tickAccumulator >= step) {
+        tickAccumulator -= step;
+        engine.tick();
+    }
+}
+
+void Game::playReplay(float dt) {
+    const float step = 1.f / Engine::TICK_RATE;
+    tickAccumulator += dt * replaySpeed;
+    while (tickAccumulator >= step) {
+        tickAccumulator -= step;
+        if (!player->step(engine)) {
+            tickAccumulator = 0.f;
+            break;
+        }
+    }
+}
+
+void Game::setAutoplay(bool enabled) {
+    botEnabled = enabled;
+    botRequest = 0;
+    botInputs.size = 0;
+    botNext = 0;
+    moveHoldKey = sf::Keyboard::Scancode::Unknown;
+    if (enabled && !bot) {
+        BotConfig config;
+        // off the frame loop, so the search can take longer than in the tools
+        config.budget = std::chrono::milliseconds(5);
+        bot = std::make_unique<AutoPlayer>(config);
+    }
+}
+
+// the same piece in the same position, not a new one spawned in its place
+static bool samePlace(const Engine& engine, const Tetromino& piece, int pieces) {
+    return engine.pieces == pieces && engine.current.pos.x == piece.pos.x && engine.current.pos.y == piece.pos.y &&
+           engine.current.rotation == piece.rotation;
+}
+
+void Game::driveBot(float dt) {
+    // gravity keeps running between inputs; once it has moved the piece off
+    // the planned path the rest of the plan is stale, so search again
+    if (botNext < botInputs.size && !samePlace(engine, botPiece, botPieces)) {
+        botInputs.size = 0;
+        botNext = 0;
+    }
+
+    // play the current plan one input per botInputDelay
+    if (botNext < botInputs.size) {
+        botTimer += dt;
+        while (botNext < botInputs.size && botTimer >= botInputDelay) {
+            feedBotInput(botInputs.inputs[botNext++]);
+            botPiece = engine.current;
+            botPieces = engine.pieces;
+            botTimer -= botInputDelay;
+        }
+        return;
+    }
+
+    BotPlan plan;
+    if (bot->poll(plan) && plan.id == botRequest) {
+        botRequest = 0;
+        // a plan searched from where the piece was before gravity moved it is dropped
+        if (samePlace(engine, botPiece, botPieces)) {
+            botInputs = plan.move.inputs;
+            if (!plan.move.found) {
+                botInputs.size = 1;
+                botInputs.inputs[0] = Input::HardDrop;
+            }
+            botNext = 0;
+            botTimer = botInputDelay;
+            return;
+        }
+    }
+    if (!botRequest) {
+        botRequest = bot->request(engine);
+        botPiece = engine.current;
+        botPieces = engine.pieces;
+    }
+}
+
+void Game::feedBotInput(Input input) {
+    static constexpr sf::Keyboard::Scancode keys[] = {
+        sf::Keyboard::Scancode::A, sf::Keyboard::Scancode::D, sf::Keyboard::Scancode::S,
+        sf::Keyboard::Scancode::W, sf::Keyboard::Scancode::Space,
+    };
+    handleKeyPress(keys[static_cast<int>(input)]);
+    // no key release will follow, so don't let DAS treat it as held
+    moveHoldKey = sf::Keyboard::Scancode::Unknown;
+}
+
 sf::Color Game::getColor(int type) {
     static sf::Color colors[] = {
         sf::Color::White, sf::Color::Cyan, sf::Color::Blue,
@@ -364,6 +540,7 @@ void Game::onResized(sf::Vector2u size) {
         window.setView(gameView);
         updateViewportPixels(w, h);
         updateUIFromViewport();
+        buildStaticLayers();
         prevSize = size;
     }
 }
@@ -375,7 +552,7 @@ void Game::updateUIFromViewport() {
 
     const sf::Vector2f anchorLogical{
         static_cast<float>(baseX),
-        static_cast<float>(baseY + previewCount * cellH)
+        static_cast<float>(baseY + engine.previewCount * cellH)
     };
 
     const sf::FloatRect b = helpText.getLocalBounds();
@@ -383,24 +560,40 @@ void Game::updateUIFromViewport() {
                            anchorLogical.y - b.position.y });
 }
 
-void Game::restartGame() {
-    score = 0;
-    gameOver = false;
-    paused = false;
+void Game::saveGame() {
+    quickSave = saveState(engine);
+    std::FILE* out = std::fopen(SAVE_PATH, "wb");
+    if (!out) return;
+    const bool ok = std::fwrite(quickSave->bytes.data(), 1, quickSave->bytes.size(), out) == quickSave->bytes.size();
+    if (std::fclose(out) != 0 || !ok) std::cerr << "Failed to write " << SAVE_PATH << std::endl;
+}
 
-    for (int y = 0; y < ROWS; ++y) {
-        for (int x = 0; x < COLS; ++x) {
-            grid[y][x] = 0;
-        }
+// A load would break the recording, so it is ignored while recording.
+void Game::loadGame() {
+    if (recorder.active()) return;
+    if (!quickSave) {
+        SaveState state;
+        std::FILE* in = std::fopen(SAVE_PATH, "rb");
+        if (!in) return;
+        const bool ok = std::fread(state.bytes.data(), 1, state.bytes.size(), in) == state.bytes.size();
+        std::fclose(in);
+        if (!ok) return;
+        quickSave = state;
     }
-
-    upcoming.clear();
-    for (int i = 0; i < previewCount; ++i) {
-        upcoming.push_back(Tetromino(rand() % 7));
+    if (!restoreState(engine, *quickSave)) {
+        std::cerr << "Ignoring corrupt save state" << std::endl;
+        quickSave.reset();
+        return;
     }
-    current = upcoming.front();
-    upcoming.pop_front();
-    upcoming.push_back(Tetromino(rand() % 7));
+    tickAccumulator = 0.f;
+    setAutoplay(botEnabled);
+}
+
+void Game::restartGame() {
+    paused = false;
+    recorder.record(engine, ReplayEvent::Restart);
+    engine.restart();
+    setAutoplay(botEnabled);
 
     const auto curSize = window.getSize();
     viewportNormalized = computeViewport(curSize.x, curSize.y, static_cast<float>(LOGICAL_W), static_cast<float>(LOGICAL_H));
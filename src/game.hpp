@@ -1,26 +1,43 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
-#include <deque>
-#include "tetromino.hpp"
-#include "grid.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "autoplayer.hpp"
+#include "engine.hpp"
+#include "profiler.hpp"
 #include "point.hpp"
+#include "replay.hpp"
+#include "savestate.hpp"
+#include "telemetry.hpp"
+
+struct GameOptions {
+    std::uint64_t seed = 0;
+    RandomizerMode randomizerMode = RandomizerMode::Uniform;
+    bool autoplay = false;
+    float botInputDelay = 0.05f;
+    // written when the window closes
+    std::string recordPath;
+    // play this replay instead of taking input
+    std::string replayPath;
+    float replaySpeed = 1.f;
+    // per-piece telemetry stream
+    std::string telemetryPath;
+    // frame timings, written when the window closes
+    std::string profilePath;
+};
 
 class Game {
 public:
-    explicit Game();
+    explicit Game(const GameOptions& options);
     void run();
 
 private:
     sf::RenderWindow window;
 
-    Grid grid = {};
-    Tetromino current;
-    std::deque<Tetromino> upcoming;
-
-    int previewCount = 5;
-    int score = 0;
-    bool gameOver = false;
+    Engine engine;
     bool paused = false;
 
     // DAS
@@ -29,12 +46,59 @@ private:
     const float dasDelay = 0.2f;
     const float dasRepeat = 0.05f;
 
+    // autoplay: the bot searches on its own thread and its inputs go through
+    // handleKeyPress; gravity keeps running, and the bot searches again when
+    // it moves the piece off the plan
+    std::unique_ptr<AutoPlayer> bot;
+    bool botEnabled = false;
+    std::uint64_t botRequest = 0;
+    InputSequence botInputs;
+    int botNext = 0;
+    // where the plan expects the current piece, and which piece it is
+    Tetromino botPiece;
+    int botPieces = 0;
+    float botTimer = 0.f;
+    float botInputDelay;
+
+    // fixed-rate engine ticks
+    float tickAccumulator = 0.f;
+
+    // replays
+    ReplayRecorder recorder;
+    std::string recordPath;
+    std::vector<std::uint8_t> replayBytes;
+    std::unique_ptr<ReplayPlayer> player;
+    float replaySpeed = 1.f;
+
+    // F5 / F9 quick save, mirrored to SAVE_PATH so it outlives the session
+    std::optional<SaveState> quickSave;
+
+    std::unique_ptr<TelemetryWriter> telemetry;
+
     // font and text
     sf::Font font;
     sf::Text scoreText;
+    sf::Text nextText;
     sf::Text gameOverText;
     sf::Text pausedText;
+    sf::Text restartText;
     sf::Text helpText;
+    sf::Text profilerText;
+    // "Autoplay" or "Replay xN"
+    sf::Text modeText;
+    int shownScore = -1;
+
+    // render
+    sf::VertexArray blockBatch{sf::PrimitiveType::Triangles};
+    sf::VertexArray gridLines{sf::PrimitiveType::Lines};
+    sf::VertexBuffer gridLinesBuffer{sf::PrimitiveType::Lines, sf::VertexBuffer::Usage::Static};
+    bool gridLinesOnGpu = false;
+
+    // profiling
+    FrameProfiler profiler;
+    std::string profilePath;
+    sf::Clock profilerRefresh;
+    bool showProfiler = false;
 
     // view
     sf::View gameView;
@@ -51,21 +115,27 @@ private:
     void handleKeyPress(sf::Keyboard::Scancode key);
     void handleEvents();
     void handleDAS(float dt);
-
-    // game logic
-    void lockAndNext();
-    int clearLines();
+    void sendInput(Input input);
+    void advanceTicks(float dt);
+    void playReplay(float dt);
+    void setAutoplay(bool enabled);
+    void driveBot(float dt);
+    void feedBotInput(Input input);
+    void saveGame();
+    void loadGame();
 
     // render
     void draw();
     void drawFixedBlocks();
     void drawBlock(int x, int y, sf::Color color, Point offset = {0, 0});
     void drawBlockAbsolute(int px, int py, sf::Color color);
+    void buildStaticLayers();
     void drawGridLines();
     void drawGhost();
     void drawCurrent();
     void drawPreviews();
     void drawScore();
+    void drawProfiler();
 
     // tools
     sf::Color getColor(int type);
@@ -1,7 +0,0 @@
-#pragma once
-#include <array>
-
-constexpr int ROWS = 20;
-constexpr int COLS = 10;
-
-using Grid = std::array<std::array<int, COLS>, ROWS>;
\ No newline at end of file
@@ -1,7 +1,43 @@
 #include "game.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
 
-int main() {
-    std::srand(static_cast<unsigned>(time(0)));
-    Game game;
+int main(int argc, char** argv) {
+    GameOptions options;
+    options.seed = (std::uint64_t{std::random_device{}()} << 32)
+        ^ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if (!std::strcmp(argv[i], "--randomizer") && i + 1 < argc
+                   && Randomizer::parseMode(argv[i + 1], options.randomizerMode)) {
+            ++i;
+        } else if (!std::strcmp(argv[i], "--bot")) {
+            options.autoplay = true;
+        } else if (!std::strcmp(argv[i], "--bot-delay") && i + 1 < argc) {
+            options.botInputDelay = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--record") && i + 1 < argc) {
+            options.recordPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc) {
+            options.replayPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--speed") && i + 1 < argc) {
+            options.replaySpeed = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--telemetry") && i + 1 < argc) {
+            options.telemetryPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--profile") && i + 1 < argc) {
+            options.profilePath = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--seed N] [--randomizer uniform|7bag|14bag]"
+                      << " [--bot] [--bot-delay SECONDS] [--record FILE] [--replay FILE [--speed X]]"
+                      << " [--telemetry FILE] [--profile FILE]" << std::endl;
+            return 2;
+        }
+    }
+
+    Game game(options);
     game.run();
 }
@@ -0,0 +1,375 @@
+// Micro-benchmarks for the tetris_core hot paths. Prints one JSON document
+// with ns/op and heap allocations/op for every case.
+//
+//   tetris_bench [--iters N] [--out results.json]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bot.hpp"
+#include "engine.hpp"
+#include "evaluator.hpp"
+#include "mcts.hpp"
+#include "rotation.hpp"
+#include "savestate.hpp"
+#include "telemetry.hpp"
+#include "tetromino.hpp"
+#include "thread_pool.hpp"
+#include "zobrist.hpp"
+
+// ---- allocation counting -------------------------------------------------
+
+static std::atomic<std::uint64_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// ---- harness ---------------------------------------------------------------
+
+template <class T>
+inline void keep(T&& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile auto sink = value;
+    sink = value;
+#endif
+}
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    // only reported by the search benchmarks
+    double nodesPerSec = 0.0;
+};
+
+static std::vector<Result> results;
+static std::uint64_t iterations = 2'000'000;
+
+template <class F>
+void measure(const std::string& name, std::uint64_t iters, F&& op) {
+    for (std::uint64_t i = 0; i < iters / 100 + 1; ++i) op(i);  // warm up
+
+    const std::uint64_t allocBefore = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < iters; ++i) op(i);
+    const auto end = std::chrono::steady_clock::now();
+    const std::uint64_t allocAfter = allocations.load();
+
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    results.push_back({name, iters, ns / iters, double(allocAfter - allocBefore) / iters});
+    std::fprintf(stderr, "%-28s %10.2f ns/op %8.3f allocs/op\n",
+                 name.c_str(), results.back().nsPerOp, results.back().allocsPerOp);
+}
+
+// ---- corpus ----------------------------------------------------------------
+
+// Small deterministic generator so the corpus is identical between versions.
+struct Lcg {
+    std::uint64_t state;
+    std::uint32_t next() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<std::uint32_t>(state >> 33);
+    }
+};
+
+constexpr int CORPUS_SIZE = 64;
+
+// Ragged stacks of height 0..12 with one gap per row, so no row is full.
+static std::vector<Grid> makeBoards(std::uint64_t seed) {
+    Lcg rng{seed};
+    std::vector<Grid> boards(CORPUS_SIZE);
+    for (int i = 0; i < CORPUS_SIZE; ++i) {
+        Grid& g = boards[i];
+        const int height = static_cast<int>(rng.next() % 13);
+        for (int y = ROWS - height; y < ROWS; ++y) {
+            const int gap = static_cast<int>(rng.next() % COLS);
+            for (int x = 0; x < COLS; ++x)
+                if (x != gap && rng.next() % 4 != 0) g.set(x, y, 1 + rng.next() % 7);
+        }
+    }
+    return boards;
+}
+
+// Same stacks with `full` complete rows added at the bottom.
+static std::vector<Grid> withFullRows(std::vector<Grid> boards, int full) {
+    for (Grid& g : boards) {
+        for (int k = 0; k < full; ++k) {
+            for (int y = 0; y < ROWS - 1; ++y) {
+                g.rows[y] = g.rows[y + 1];
+                g.colors[y] = g.colors[y + 1];
+            }
+            g.rows[ROWS - 1] = 0;
+            for (int x = 0; x < COLS; ++x) g.set(x, ROWS - 1, 1);
+        }
+    }
+    return boards;
+}
+
+static std::vector<Tetromino> makePieces(std::uint64_t seed) {
+    Lcg rng{seed};
+    std::vector<Tetromino> pieces;
+    for (int i = 0; i < CORPUS_SIZE; ++i) {
+        Tetromino t(static_cast<int>(rng.next() % 7));
+        const int turns = static_cast<int>(rng.next() % 4);
+        for (int r = 0; r < turns; ++r) t.rotate(Grid{});
+        t.pos.y += 1;
+        pieces.push_back(t);
+    }
+    return pieces;
+}
+
+// ---- output ----------------------------------------------------------------
+
+static bool writeJson(std::FILE* out) {
+    std::fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.4f",
+                     r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.nsPerOp, r.allocsPerOp);
+        if (r.nodesPerSec > 0.0) std::fprintf(out, ", \"nodes_per_sec\": %.0f", r.nodesPerSec);
+        std::fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    return std::ferror(out) == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--iters") && i + 1 < argc) iterations = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: %s [--iters N] [--out file.json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const std::vector<Grid> boards = makeBoards(1);
+    const std::vector<Grid> boards1 = withFullRows(boards, 1);
+    const std::vector<Grid> boards4 = withFullRows(boards, 4);
+    const std::vector<Tetromino> pieces = makePieces(2);
+    const Point moves[3] = {{-1, 0}, {1, 0}, {0, 1}};
+
+    measure("tetromino_move", iterations, [&](std::uint64_t i) {
+        Tetromino t = pieces[i % CORPUS_SIZE];
+        keep(t.move(moves[i % 3], boards[(i / 3) % CORPUS_SIZE]));
+        keep(t.pos);
+    });
+
+    measure("tetromino_is_valid", iterations, [&](std::uint64_t i) {
+        keep(pieces[i % CORPUS_SIZE].isValid(boards[(i / 7) % CORPUS_SIZE]));
+    });
+
+    measure("apply_rotation", iterations, [&](std::uint64_t i) {
+        Tetromino t = pieces[i % CORPUS_SIZE];
+        applyRotation(t, boards[(i / 7) % CORPUS_SIZE]);
+        keep(t.rotation);
+    });
+
+    measure("grid_copy", iterations, [&](std::uint64_t i) {
+        Grid g = boards[i % CORPUS_SIZE];
+        keep(g.rows[0]);
+    });
+
+    // each clear works on a fresh copy, so these include one grid_copy
+    const std::vector<Grid>* clearCases[3] = {&boards, &boards1, &boards4};
+    const char* clearNames[3] = {"clear_lines_0", "clear_lines_1", "clear_lines_4"};
+    for (int c = 0; c < 3; ++c) {
+        measure(clearNames[c], iterations, [&](std::uint64_t i) {
+            Grid g = (*clearCases[c])[i % CORPUS_SIZE];
+            keep(g.clearFullRows());
+        });
+    }
+
+    measure("ghost_drop", iterations, [&](std::uint64_t i) {
+        Tetromino ghost = pieces[i % CORPUS_SIZE];
+        const Grid& grid = boards[(i / 7) % CORPUS_SIZE];
+        while (ghost.move({0, 1}, grid)) {}
+        keep(ghost.pos);
+    });
+
+    measure("zobrist_board", iterations, [&](std::uint64_t i) {
+        keep(Zobrist::board(boards[i % CORPUS_SIZE]));
+    });
+
+    measure("evaluate_board", iterations, [&](std::uint64_t i) {
+        keep(evaluateBoard(boards[i % CORPUS_SIZE], 0, DEFAULT_WEIGHTS));
+    });
+
+    // hard-dropped piece locked into a fresh copy of the board, then the
+    // next piece is pulled from the queue
+    Engine engine;
+    measure("lock_and_next", iterations, [&](std::uint64_t i) {
+        engine.grid = boards1[(i / 7) % CORPUS_SIZE];
+        engine.gameOver = false;
+        engine.current = pieces[i % CORPUS_SIZE];
+        while (engine.current.move({0, 1}, engine.grid)) {}
+        engine.lockAndNext();
+        keep(engine.score);
+    });
+
+    // Telemetry on a headless stand-in for a Game::run frame: one planned bot
+    // input and one engine tick, paced at FRAME_HZ so the flush thread keeps
+    // up as it does in the game. Plans are searched between frames, as the
+    // AutoPlayer thread does, and only the frame work is timed. Telemetry is
+    // attached for every other piece so both sets of frames see the same mix
+    // of moves, locks and line clears. The overhead is reported against the
+    // measured frame without telemetry, not a nominal frame budget. The
+    // event file goes to the temp directory and is removed afterwards.
+    {
+        constexpr int FRAME_HZ = 1000;
+        using Clock = std::chrono::steady_clock;
+        std::error_code ec;
+        const std::filesystem::path path = std::filesystem::temp_directory_path(ec) / "tetris_bench_telemetry.bin";
+        auto writer = std::make_unique<TelemetryWriter>();
+        if (!ec && writer->open(path.string().c_str())) {
+            Engine game(1, RandomizerMode::Bag7);
+            BeamSearch bot({1, 1, std::chrono::microseconds(0)});
+            BotMove plan;
+            int next = 0;
+            int planned = -1;
+            std::vector<double> busy[2];
+            std::uint64_t allocs[2] = {};
+            auto deadline = Clock::now();
+            for (std::uint64_t f = 0; f < iterations / 500 + 2; ++f) {
+                if (game.gameOver) game.restart();
+                if (planned != game.pieces) {
+                    plan = bot.search(game);
+                    next = 0;
+                    planned = game.pieces;
+                }
+                const int on = game.pieces & 1;
+                game.telemetry = on ? writer.get() : nullptr;
+
+                const std::uint64_t allocBefore = allocations.load();
+                const auto start = Clock::now();
+                game.apply(next < plan.inputs.size ? plan.inputs.inputs[next++] : Input::HardDrop);
+                game.tick();
+                busy[on].push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+                allocs[on] += allocations.load() - allocBefore;
+
+                deadline += std::chrono::microseconds(1'000'000 / FRAME_HZ);
+                std::this_thread::sleep_until(deadline);
+            }
+            writer->close();
+
+            // the slowest 1% of frames are dropped as scheduler noise
+            const char* names[2] = {"game_frame", "game_frame_telemetry"};
+            for (int on = 0; on < 2; ++on) {
+                std::vector<double>& t = busy[on];
+                std::sort(t.begin(), t.end());
+                const std::size_t kept = t.size() - t.size() / 100;
+                double sum = 0.0;
+                for (std::size_t i = 0; i < kept; ++i) sum += t[i];
+                results.push_back({names[on], t.size(), sum / kept, double(allocs[on]) / t.size()});
+                std::fprintf(stderr, "%-28s %10.2f ns/op %8.3f allocs/op\n", names[on], results.back().nsPerOp,
+                             results.back().allocsPerOp);
+            }
+            const double base = results[results.size() - 2].nsPerOp;
+            const double extra = results.back().nsPerOp - base;
+            std::fprintf(stderr, "%28s %+10.2f ns/frame: %+.2f%% of the headless frame\n", "", extra,
+                         100.0 * extra / base);
+            std::fprintf(stderr, "%28s %10llu events written, %llu dropped\n", "",
+                         static_cast<unsigned long long>(writer->writtenEvents()),
+                         static_cast<unsigned long long>(writer->droppedEvents()));
+        }
+        std::filesystem::remove(path, ec);
+    }
+
+    // 63-byte snapshots of the corpus boards and back
+    std::vector<SaveState> saves;
+    for (const Grid& g : boards) {
+        engine.grid = g;
+        saves.push_back(saveState(engine));
+    }
+    measure("save_state", iterations, [&](std::uint64_t i) {
+        engine.grid = boards[i % CORPUS_SIZE];
+        keep(saveState(engine).bytes[0]);
+    });
+    measure("restore_state", iterations, [&](std::uint64_t i) {
+        keep(restoreState(engine, saves[i % CORPUS_SIZE]));
+    });
+
+    // one bot decision over current piece + previews, no time budget
+    const int queue[5] = {0, 1, 2, 3, 4};
+    for (const auto& [width, depth] : {std::pair{1, 1}, std::pair{8, 2}, std::pair{16, 3}}) {
+        BeamSearch bot({width, depth, std::chrono::microseconds(0)});
+        measure("beam_search_w" + std::to_string(width) + "_d" + std::to_string(depth),
+                iterations / 2000 + 1, [&](std::uint64_t i) {
+            keep(bot.search(boards[i % CORPUS_SIZE], pieces[i % CORPUS_SIZE], queue, 5).score);
+        });
+    }
+
+    // same search with a 4 MB table; the corpus repeats, so later passes
+    // mostly hit
+    {
+        BotConfig config{16, 3, std::chrono::microseconds(0)};
+        config.ttMegabytes = 4;
+        BeamSearch bot(config);
+        measure("beam_search_w16_d3_tt4", iterations / 2000 + 1, [&](std::uint64_t i) {
+            keep(bot.search(boards[i % CORPUS_SIZE], pieces[i % CORPUS_SIZE], queue, 5).score);
+        });
+        const TTStats tt = bot.transpositions()->stats();
+        std::fprintf(stderr, "%28s %10.1f%% hits %llu replaced\n", "",
+                     100.0 * tt.hits / std::max<std::uint64_t>(tt.hits + tt.misses, 1),
+                     static_cast<unsigned long long>(tt.replacements));
+    }
+
+    // one frame-sized MCTS step from a fresh root
+    {
+        MonteCarloSearch mcts;
+        measure("mcts_step_1ms", iterations / 20000 + 1, [&](std::uint64_t i) {
+            mcts.reset(boards[i % CORPUS_SIZE], pieces[i % CORPUS_SIZE], queue, 5);
+            keep(mcts.step(1000));
+        });
+        const MctsStats st = mcts.stats();
+        results.back().nodesPerSec = st.playoutsPerSec;
+        std::fprintf(stderr, "%28s %10.0f playouts/s %zu nodes, %zu KB\n", "", st.playoutsPerSec, st.nodes,
+                     st.bytes / 1024);
+    }
+
+    // thread scaling of a wider search: 1, 2, 4, ... up to every hardware thread
+    const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        ThreadPool pool(threads);
+        BeamSearch bot({32, 3, std::chrono::microseconds(0)}, weightedEvaluator(), &pool);
+        const auto start = std::chrono::steady_clock::now();
+        measure("beam_search_w32_d3_threads_" + std::to_string(threads), iterations / 20000 + 1, [&](std::uint64_t i) {
+            keep(bot.search(boards[i % CORPUS_SIZE], pieces[i % CORPUS_SIZE], queue, 5).score);
+        });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        results.back().nodesPerSec = bot.nodes / seconds;
+        std::fprintf(stderr, "%28s %10.0f nodes/s\n", "", results.back().nodesPerSec);
+        if (threads == maxThreads) break;
+    }
+
+    if (outPath) {
+        std::FILE* out = std::fopen(outPath, "w");
+        if (!out || !writeJson(out)) {
+            std::fprintf(stderr, "Failed to write %s\n", outPath);
+            return 1;
+        }
+        std::fclose(out);
+    } else {
+        writeJson(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,318 @@
+// Self-checks for the parts of the core whose bugs do not show up as wrong
+// perft counts: the thread pool's scheduling guarantees, the bit-parallel
+// evaluator against a cell-by-cell reference, and the move generator's input
+// paths, and the transposition table's packed entries. Run it under
+// ThreadSanitizer after touching the pool.
+//
+//   tetris_check                run every check
+//   tetris_check pool eval      run the named checks only
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "bot.hpp"
+#include "evaluator.hpp"
+#include "movegen.hpp"
+#include "shapes.hpp"
+#include "thread_pool.hpp"
+#include "transposition.hpp"
+
+// Nested parallelFor at three levels. Each level has one scratch slot per
+// worker index; a slot found busy on entry means two bodies of the same level
+// were handed the same index at once.
+static int checkPool() {
+    constexpr int LEVELS = 3;
+    int failures = 0;
+    for (unsigned threads : {1u, 2u, 3u, 4u, 8u}) {
+        ThreadPool pool(threads);
+        std::vector<std::unique_ptr<std::atomic<bool>[]>> busy;
+        for (int level = 0; level < LEVELS; ++level) {
+            busy.push_back(std::make_unique<std::atomic<bool>[]>(pool.size()));
+            for (unsigned w = 0; w < pool.size(); ++w) busy[level][w] = false;
+        }
+        std::atomic<std::uint64_t> clashes{0}, badWorkers{0}, badCounts{0};
+
+        auto enter = [&](int level, unsigned worker) {
+            if (worker >= pool.size()) {
+                ++badWorkers;
+                return false;
+            }
+            if (busy[level][worker].exchange(true)) ++clashes;
+            return true;
+        };
+        auto leave = [&](int level, unsigned worker) { busy[level][worker] = false; };
+
+        for (int round = 0; round < 10; ++round) {
+            const std::size_t n = 1 + static_cast<std::size_t>(round) * 37 % 700;
+            std::vector<std::atomic<int>> hits(n);
+            pool.parallelFor(n, [&](std::size_t i, unsigned worker) {
+                if (!enter(0, worker)) return;
+                ++hits[i];
+                if (i % 5 == 0) {
+                    std::vector<std::atomic<int>> inner(24);
+                    pool.parallelFor(inner.size(), [&](std::size_t j, unsigned w) {
+                        if (!enter(1, w)) return;
+                        ++inner[j];
+                        // long enough for idle workers to steal the rest of this loop
+                        std::this_thread::sleep_for(std::chrono::microseconds(50));
+                        if (j % 8 == 0) {
+                            std::atomic<int> leaves{0};
+                            pool.parallelFor(6, [&](std::size_t, unsigned v) {
+                                if (!enter(2, v)) return;
+                                ++leaves;
+                                leave(2, v);
+                            });
+                            if (leaves != 6) ++badCounts;
+                        }
+                        leave(1, w);
+                    });
+                    for (const auto& h : inner)
+                        if (h != 1) ++badCounts;
+                }
+                leave(0, worker);
+            });
+            for (const auto& h : hits)
+                if (h != 1) ++badCounts;
+        }
+
+        const bool ok = !clashes && !badWorkers && !badCounts;
+        std::printf("pool     %u threads  %llu scratch clashes  %llu bad workers  %llu bad counts  %s\n", threads,
+                    static_cast<unsigned long long>(clashes.load()),
+                    static_cast<unsigned long long>(badWorkers.load()),
+                    static_cast<unsigned long long>(badCounts.load()), ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+    return failures;
+}
+
+// The evaluator's features, one cell at a time, straight from their
+// definitions.
+static BoardFeatures referenceFeatures(const Grid& grid, int linesCleared) {
+    BoardFeatures f;
+    int holes = 0, covered = 0, rowTransitions = 0, columnTransitions = 0;
+    for (int x = 0; x < COLS; ++x) {
+        int top = ROWS;
+        while (top > 0 && !grid.occupied(x, ROWS - top)) --top;
+        f.heights[x] = static_cast<std::uint8_t>(top);
+        for (int y = ROWS - top; y < ROWS; ++y) {
+            if (grid.occupied(x, y)) {
+                for (int below = y + 1; below < ROWS; ++below)
+                    if (!grid.occupied(x, below)) {
+                        ++covered;
+                        break;
+                    }
+            } else {
+                ++holes;
+            }
+        }
+        // empty above the board, the floor filled
+        bool previous = false;
+        for (int y = 0; y <= ROWS; ++y) {
+            const bool filled = y == ROWS || grid.occupied(x, y);
+            columnTransitions += filled != previous;
+            previous = filled;
+        }
+    }
+    for (int y = 0; y < ROWS; ++y) {
+        // walls filled on both sides
+        bool previous = true;
+        for (int x = 0; x <= COLS; ++x) {
+            const bool filled = x == COLS || grid.occupied(x, y);
+            rowTransitions += filled != previous;
+            previous = filled;
+        }
+    }
+
+    int aggregate = 0, maxHeight = 0, wellDepth = 0, bumpiness = 0;
+    for (int x = 0; x < COLS; ++x) {
+        const int h = f.heights[x];
+        const int left = x > 0 ? f.heights[x - 1] : ROWS;
+        const int right = x + 1 < COLS ? f.heights[x + 1] : ROWS;
+        f.wells[x] = static_cast<std::uint8_t>(std::max(0, std::min(left, right) - h));
+        wellDepth += f.wells[x];
+        aggregate += h;
+        maxHeight = std::max(maxHeight, h);
+        if (x + 1 < COLS) bumpiness += std::abs(h - right);
+    }
+    f.values = {float(aggregate), float(maxHeight), float(holes), float(covered), float(wellDepth),
+                float(rowTransitions), float(columnTransitions), float(bumpiness), float(linesCleared)};
+    return f;
+}
+
+// Random stacks of random height with random gaps, and now and then a board
+// of pure noise.
+static void randomBoard(std::mt19937_64& rng, Grid& grid) {
+    grid.clear();
+    const int height = static_cast<int>(rng() % (ROWS + 1));
+    const bool noise = rng() % 8 == 0;
+    const unsigned density = 1 + static_cast<unsigned>(rng() % 8);
+    for (int y = ROWS - height; y < ROWS; ++y)
+        for (int x = 0; x < COLS; ++x)
+            if (noise ? rng() % 2 : rng() % 10 < density + 2) grid.set(x, y, 1);
+}
+
+static int checkEvaluator() {
+    constexpr int BOARDS = 200000;
+    std::mt19937_64 rng(1);
+    Grid grid;
+    int mismatches = 0;
+    for (int i = 0; i < BOARDS; ++i) {
+        randomBoard(rng, grid);
+        const int lines = static_cast<int>(rng() % 5);
+        const BoardFeatures fast = boardFeatures(grid, lines);
+        const BoardFeatures slow = referenceFeatures(grid, lines);
+        const bool same = fast.heights == slow.heights && fast.wells == slow.wells && fast.values == slow.values &&
+                          evaluateBoard(grid, lines, DEFAULT_WEIGHTS) == weightedScore(slow.values, DEFAULT_WEIGHTS);
+        if (!same && mismatches++ < 5) {
+            std::printf("eval     board %d differs:", i);
+            for (int f = 0; f < FEATURE_COUNT; ++f)
+                if (fast.values[f] != slow.values[f])
+                    std::printf(" %s %g vs %g", featureName(f), fast.values[f], slow.values[f]);
+            std::printf("\n");
+        }
+    }
+    std::printf("eval     %d random boards  %d mismatches  %s\n", BOARDS, mismatches, mismatches ? "FAIL" : "ok");
+    return mismatches ? 1 : 0;
+}
+
+// Replays the inputs path() gives for every generated placement through the
+// Tetromino API, the way the engine applies them, and expects to land on the
+// placement.
+static int checkPaths() {
+    constexpr int BOARDS = 2000;
+    std::mt19937_64 rng(2);
+    MoveGenerator generator;
+    PlacementList list;
+    InputSequence inputs;
+    Grid grid;
+    long placements = 0;
+    int failures = 0;
+    for (int i = 0; i < BOARDS; ++i) {
+        randomBoard(rng, grid);
+        grid.clearFullRows();
+        for (int type = 0; type < PIECE_TYPES; ++type) {
+            generator.generate(grid, Tetromino(type), list);
+            for (const Placement& p : list) {
+                ++placements;
+                Tetromino piece(type);
+                bool ok = generator.path(p, inputs) && inputs.size > 0 &&
+                          inputs.inputs[inputs.size - 1] == Input::HardDrop;
+                for (int k = 0; ok && k < inputs.size; ++k) {
+                    switch (inputs.inputs[k]) {
+                        case Input::Left: ok = piece.move({-1, 0}, grid); break;
+                        case Input::Right: ok = piece.move({1, 0}, grid); break;
+                        case Input::SoftDrop: ok = piece.move({0, 1}, grid); break;
+                        case Input::Rotate: piece.rotate(grid); break;
+                        case Input::HardDrop: while (piece.move({0, 1}, grid)) {} break;
+                    }
+                }
+                ok = ok && piece.pos.x == p.piece.pos.x && piece.pos.y == p.piece.pos.y &&
+                     piece.rotation == p.piece.rotation;
+                if (!ok && failures++ < 5)
+                    std::printf("paths    board %d piece %c: path to (%d, %d) rotation %d ends at (%d, %d) rotation %d\n",
+                                i, PIECE_NAMES[type], p.piece.pos.x, p.piece.pos.y, p.piece.rotation, piece.pos.x,
+                                piece.pos.y, piece.rotation);
+            }
+        }
+    }
+    std::printf("paths    %ld placements on %d random boards  %d bad paths  %s\n", placements, BOARDS, failures,
+                failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
+
+// Entries read back as stored, move included, over the move generator's whole
+// range; and a repeated beam search of one position returns the stored move,
+// without searching again when the first search went the full depth.
+static int checkTransposition() {
+    int failures = 0;
+    TranspositionTable table(1);
+    std::mt19937_64 rng(3);
+    for (int i = 0; i < 100000; ++i) {
+        const std::uint64_t key = rng();
+        TTEntry in;
+        in.value = static_cast<float>(static_cast<int>(rng() % 20001) - 10000) / 7.f;
+        in.depth = static_cast<std::uint8_t>(rng() % 8);
+        in.hasMove = rng() % 2;
+        if (in.hasMove) {
+            in.moveX = static_cast<std::int8_t>(static_cast<int>(rng() % 16) - 4);
+            in.moveY = static_cast<std::int8_t>(static_cast<int>(rng() % 32) - 4);
+            in.moveRotation = static_cast<std::uint8_t>(rng() % 4);
+        }
+        table.store(key, in);
+        TTEntry out;
+        const bool same = table.probe(key, out) && out.value == in.value && out.depth == in.depth &&
+                          out.hasMove == in.hasMove && out.moveX == in.moveX && out.moveY == in.moveY &&
+                          out.moveRotation == in.moveRotation;
+        if (!same && failures++ < 5) std::printf("tt       entry %d reads back differently\n", i);
+    }
+
+    BotConfig config;
+    config.beamWidth = 64;
+    config.budget = {};
+    config.ttMegabytes = 1;
+    BeamSearch bot(config);
+    std::mt19937_64 boards(4);
+    Grid grid;
+    const int queue[] = {1, 4, 6};
+    int repeats = 0;
+    for (int i = 0; i < 200; ++i) {
+        randomBoard(boards, grid);
+        grid.clearFullRows();
+        const Tetromino current(i % PIECE_TYPES);
+        const BotMove first = bot.search(grid, current, queue, 3);
+        const std::uint64_t before = bot.nodes;
+        const BotMove again = bot.search(grid, current, queue, 3);
+        // a board near the top can end the search early; that one is searched again
+        const bool searchedAgain = bot.nodes != before;
+        const bool fullDepth = first.found && first.depthReached == config.depth;
+        const bool same = again.found == first.found && searchedAgain == (first.found && !fullDepth) &&
+                          (!first.found || (again.target.pos.x == first.target.pos.x &&
+                                            again.target.pos.y == first.target.pos.y &&
+                                            again.target.rotation == first.target.rotation &&
+                                            again.score == first.score));
+        repeats += fullDepth;
+        if (!same && failures++ < 5) std::printf("tt       board %d: repeated search differs\n", i);
+    }
+    std::printf("tt       100000 entries  %d searches answered from the table  %d failures  %s\n", repeats, failures,
+                failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
+
+struct Check {
+    const char* name;
+    int (*run)();
+};
+
+static const Check checks[] = {
+    {"pool", checkPool},
+    {"eval", checkEvaluator},
+    {"paths", checkPaths},
+    {"tt", checkTransposition},
+};
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        bool known = false;
+        for (const Check& c : checks) known = known || !std::strcmp(argv[i], c.name);
+        if (!known) {
+            std::fprintf(stderr, "usage: %s [pool] [eval] [paths] [tt]...\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int failures = 0;
+    for (const Check& c : checks) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) selected = selected || !std::strcmp(argv[i], c.name);
+        if (selected) failures += c.run();
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+// Perft for the placement generator: counts every reachable sequence of lock
+// positions for a fixed piece order, to a given depth. The counts pin down the
+// behaviour of collision, rotation, kicks and line clears; the timing gives a
+// single nodes/sec figure to watch while optimizing them.
+//
+//   tetris_perft                          run the reference suite
+//   tetris_perft --position NAME --sequence TIOL --depth N
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "movegen.hpp"
+#include "shapes.hpp"
+
+struct Position {
+    const char* name;
+    // bottom rows of the board, top to bottom; '#' is filled
+    std::vector<const char*> rows;
+};
+
+static const std::vector<Position> positions = {
+    {"empty", {}},
+    {"ragged", {
+        "......#...",
+        "#...###..#",
+        "##.####.##",
+        "####.#####",
+        "#.########",
+    }},
+    {"tspin", {
+        "###.......",
+        "##...#####",
+        "###.######",
+    }},
+    {"tetris", {
+        "#########.",
+        "#########.",
+        "#########.",
+        "#########.",
+    }},
+};
+
+struct Reference {
+    const char* position;
+    const char* sequence;
+    int depth;
+    std::uint64_t count;
+};
+
+static const std::vector<Reference> references = {
+    {"empty", "TIOLJSZ", 1, 34},
+    {"empty", "TIOLJSZ", 2, 596},
+    {"empty", "TIOLJSZ", 3, 5542},
+    {"empty", "TIOLJSZ", 4, 199278},
+    {"ragged", "TIOLJSZ", 2, 588},
+    {"ragged", "TIOLJSZ", 4, 197736},
+    {"tspin", "TIOLJSZ", 1, 37},
+    {"tspin", "TIOLJSZ", 4, 216051},
+    {"tetris", "IOTLJSZ", 2, 153},
+    {"tetris", "IOTLJSZ", 4, 188094},
+};
+
+static bool buildGrid(const char* name, Grid& grid) {
+    for (const Position& p : positions) {
+        if (std::strcmp(p.name, name)) continue;
+        grid.clear();
+        const int top = ROWS - static_cast<int>(p.rows.size());
+        for (std::size_t r = 0; r < p.rows.size(); ++r)
+            for (int x = 0; x < COLS && p.rows[r][x]; ++x)
+                if (p.rows[r][x] == '#') grid.set(x, top + static_cast<int>(r), 8);
+        return true;
+    }
+    return false;
+}
+
+static bool parseSequence(const char* text, std::vector<int>& types) {
+    types.clear();
+    for (const char* c = text; *c; ++c) {
+        const char* at = std::strchr(PIECE_NAMES, *c);
+        if (!at) return false;
+        types.push_back(static_cast<int>(at - PIECE_NAMES));
+    }
+    return !types.empty();
+}
+
+class Perft {
+public:
+    MoveGenerator generator;
+
+    std::uint64_t run(const Grid& grid, const std::vector<int>& sequence, int depth) {
+        this->sequence = &sequence;
+        lists.resize(depth);
+        return count(grid, 0, depth);
+    }
+
+private:
+    const std::vector<int>* sequence = nullptr;
+    std::vector<PlacementList> lists;
+
+    std::uint64_t count(const Grid& grid, int ply, int depth) {
+        if (depth == 0) return 1;
+
+        PlacementList& list = lists[ply];
+        const int type = (*sequence)[ply % sequence->size()];
+        generator.generate(grid, Tetromino(type), list);
+        if (depth == 1) return static_cast<std::uint64_t>(list.size);
+
+        std::uint64_t total = 0;
+        for (const Placement& p : list) {
+            Grid next = grid;
+            p.piece.lock(next);
+            next.clearFullRows();
+            total += count(next, ply + 1, depth - 1);
+        }
+        return total;
+    }
+};
+
+struct Timed {
+    std::uint64_t count;
+    double seconds;
+    std::uint64_t searchNodes;
+};
+
+static Timed timedRun(const Grid& grid, const std::vector<int>& sequence, int depth) {
+    Perft perft;
+    const auto start = std::chrono::steady_clock::now();
+    const std::uint64_t count = perft.run(grid, sequence, depth);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {count, seconds, perft.generator.nodes};
+}
+
+static void report(const char* position, const char* sequence, int depth, const Timed& t) {
+    std::printf("%-8s %-8s depth %d  count %12llu  %8.3f s  %7.2f M placements/s  %7.2f M search nodes/s",
+                position, sequence, depth, static_cast<unsigned long long>(t.count), t.seconds,
+                t.count / t.seconds / 1e6, t.searchNodes / t.seconds / 1e6);
+}
+
+int main(int argc, char** argv) {
+    const char* position = nullptr;
+    const char* sequenceText = "TIOLJSZ";
+    int depth = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--position") && i + 1 < argc) position = argv[++i];
+        else if (!std::strcmp(argv[i], "--sequence") && i + 1 < argc) sequenceText = argv[++i];
+        else if (!std::strcmp(argv[i], "--depth") && i + 1 < argc) depth = std::atoi(argv[++i]);
+        else {
+            std::fprintf(stderr, "usage: %s [--position empty|ragged|tspin|tetris] [--sequence TIOLJSZ] [--depth N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Grid grid;
+    std::vector<int> sequence;
+
+    if (position) {
+        if (!buildGrid(position, grid)) {
+            std::fprintf(stderr, "Unknown position %s\n", position);
+            return 2;
+        }
+        if (!parseSequence(sequenceText, sequence) || depth < 1) {
+            std::fprintf(stderr, "Bad sequence or depth\n");
+            return 2;
+        }
+        report(position, sequenceText, depth, timedRun(grid, sequence, depth));
+        std::printf("\n");
+        return 0;
+    }
+
+    int failures = 0;
+    for (const Reference& ref : references) {
+        buildGrid(ref.position, grid);
+        parseSequence(ref.sequence, sequence);
+        const Timed t = timedRun(grid, sequence, ref.depth);
+        report(ref.position, ref.sequence, ref.depth, t);
+        if (t.count == ref.count) {
+            std::printf("  ok\n");
+        } else {
+            std::printf("  FAIL (expected %llu)\n", static_cast<unsigned long long>(ref.count));
+            ++failures;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+// Replay tool: re-simulates recorded games headlessly as fast as possible and
+// checks that each one ends in the recorded state, or records new ones with
+// the bot for regression runs. Corpora are re-simulated on every core
+// straight out of the mapped file.
+//
+//   tetris_replay game1.trpl game2.trpl ...
+//   tetris_replay --make bot.trpl --seed 7 --pieces 500
+//   tetris_replay --make-corpus games.trpc --games 10000 --pieces 200
+//   tetris_replay --append games.trpc game1.trpl game2.trpl
+//   tetris_replay --corpus games.trpc
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "bot.hpp"
+#include "corpus.hpp"
+#include "engine.hpp"
+#include "replay.hpp"
+#include "thread_pool.hpp"
+
+// Plays `pieces` pieces with the greedy bot through real inputs, letting a few
+// ticks of gravity pass between inputs so the recording exercises it. When
+// gravity pulls the piece off the planned path the bot searches again from
+// where it is.
+static Engine recordBotGame(std::uint64_t seed, RandomizerMode mode, int pieces, BeamSearch& bot,
+                            std::vector<std::uint8_t>& out) {
+    Engine engine(seed, mode);
+    ReplayRecorder recorder;
+    recorder.begin(engine);
+
+    while (!engine.gameOver && engine.pieces < pieces) {
+        const BotMove move = bot.search(engine);
+        const int before = engine.pieces;
+        for (int i = 0; i < move.inputs.size && engine.pieces == before; ++i) {
+            recorder.record(engine, static_cast<ReplayEvent>(move.inputs.inputs[i]));
+            engine.apply(move.inputs.inputs[i]);
+            const int planned = engine.current.pos.y;
+            for (int t = 0; t < 3 && engine.pieces == before; ++t) engine.tick();
+            if (engine.pieces == before && engine.current.pos.y != planned) break;
+        }
+        if (!move.found) {
+            recorder.record(engine, ReplayEvent::HardDrop);
+            engine.apply(Input::HardDrop);
+        }
+    }
+    recorder.finish(engine, out);
+    return engine;
+}
+
+static bool makeReplay(const char* path, std::uint64_t seed, RandomizerMode mode, int pieces) {
+    BeamSearch bot({1, 1, std::chrono::microseconds(0)});
+    std::vector<std::uint8_t> bytes;
+    const Engine engine = recordBotGame(seed, mode, pieces, bot, bytes);
+
+    std::FILE* out = std::fopen(path, "wb");
+    if (!out) return false;
+    const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+    if (std::fclose(out) != 0 || !ok) return false;
+    std::printf("%s: %d pieces, %d lines, score %d, %u ticks\n", path, engine.pieces, engine.lines, engine.score,
+                engine.ticks);
+    return true;
+}
+
+// Game i uses seed + i, so the corpus can be regenerated exactly.
+static bool makeCorpus(const char* path, std::uint64_t seed, RandomizerMode mode, int games, int pieces) {
+    ThreadPool pool;
+    std::vector<std::unique_ptr<BeamSearch>> bots;
+    for (unsigned i = 0; i < pool.size(); ++i)
+        bots.push_back(std::make_unique<BeamSearch>(BotConfig{1, 1, std::chrono::microseconds(0)}));
+
+    std::vector<std::vector<std::uint8_t>> replays(games);
+    pool.parallelFor(replays.size(), [&](std::size_t i, unsigned worker) {
+        recordBotGame(seed + i, mode, pieces, *bots[worker], replays[i]);
+    });
+    if (!ReplayCorpus::append(path, replays)) return false;
+    std::printf("%s: appended %d replays\n", path, games);
+    return true;
+}
+
+static bool appendFiles(const char* path, const std::vector<const char*>& files) {
+    std::vector<std::vector<std::uint8_t>> replays(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        ReplayView view;
+        if (!readBinaryFile(files[i], replays[i]) || !view.parse(replays[i].data(), replays[i].size())) {
+            std::fprintf(stderr, "%s is not a replay\n", files[i]);
+            return false;
+        }
+        replays[i].resize(view.size());
+    }
+    if (!ReplayCorpus::append(path, replays)) return false;
+    std::printf("%s: appended %zu replays\n", path, files.size());
+    return true;
+}
+
+// Re-simulates every replay of the corpus in parallel, reading the events in
+// place from the mapping.
+static int simulateCorpus(const char* path) {
+    ReplayCorpus corpus;
+    if (!corpus.open(path)) {
+        std::fprintf(stderr, "Failed to open corpus %s\n", path);
+        return 1;
+    }
+
+    ThreadPool pool;
+    std::atomic<std::uint64_t> pieces{0}, ticks{0}, failures{0};
+    const auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(corpus.size(), [&](std::size_t i, unsigned) {
+        ReplayView view;
+        if (!corpus.view(i, view)) {
+            failures.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ReplayPlayer player(view);
+        Engine engine = player.start();
+        if (!player.run(engine)) failures.fetch_add(1, std::memory_order_relaxed);
+        pieces.fetch_add(engine.pieces, std::memory_order_relaxed);
+        ticks.fetch_add(engine.ticks, std::memory_order_relaxed);
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%s: %zu replays (%s), %u threads, %.3f s\n", path, corpus.size(),
+                corpus.mapped() ? "mmap" : "read", pool.size(), seconds);
+    std::printf("%.0f replays/s, %.0f pieces/s, %.0f ticks/s, %llu mismatches\n", corpus.size() / seconds,
+                pieces / seconds, ticks / seconds, static_cast<unsigned long long>(failures.load()));
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    const char* makePath = nullptr;
+    const char* makeCorpusPath = nullptr;
+    const char* appendPath = nullptr;
+    const char* corpusPath = nullptr;
+    std::uint64_t seed = 1;
+    RandomizerMode mode = RandomizerMode::Bag7;
+    int pieces = 500;
+    int games = 1000;
+    std::vector<const char*> files;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--make") && hasValue) makePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--make-corpus") && hasValue) makeCorpusPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--append") && hasValue) appendPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--corpus") && hasValue) corpusPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--games") && hasValue) games = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (!std::strcmp(argv[i], "--pieces") && hasValue) pieces = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--randomizer") && hasValue && Randomizer::parseMode(argv[i + 1], mode)) ++i;
+        else if (argv[i][0] != '-') files.push_back(argv[i]);
+        else {
+            std::fprintf(stderr,
+                         "usage: %s FILE...\n"
+                         "       %s --make FILE [--seed N] [--pieces N] [--randomizer uniform|7bag|14bag]\n"
+                         "       %s --make-corpus CORPUS [--games N] [--seed N] [--pieces N] [--randomizer MODE]\n"
+                         "       %s --append CORPUS FILE...\n"
+                         "       %s --corpus CORPUS\n",
+                         argv[0], argv[0], argv[0], argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+    if (corpusPath) return simulateCorpus(corpusPath);
+    if (appendPath) return appendFiles(appendPath, files) ? 0 : 1;
+    if (makeCorpusPath) {
+        if (makeCorpus(makeCorpusPath, seed, mode, games, pieces)) return 0;
+        std::fprintf(stderr, "Failed to write %s\n", makeCorpusPath);
+        return 1;
+    }
+    if (makePath) {
+        if (makeReplay(makePath, seed, mode, pieces)) return 0;
+        std::fprintf(stderr, "Failed to write %s\n", makePath);
+        return 1;
+    }
+
+    std::vector<std::uint8_t> bytes;
+    std::uint64_t totalPieces = 0, totalTicks = 0;
+    double seconds = 0.0;
+    int failures = 0;
+    for (const char* path : files) {
+        ReplayView view;
+        if (!readBinaryFile(path, bytes) || !view.parse(bytes.data(), bytes.size())) {
+            std::printf("%s: unreadable\n", path);
+            ++failures;
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        ReplayPlayer player(view);
+        Engine engine = player.start();
+        const bool ok = player.run(engine);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        totalPieces += engine.pieces;
+        totalTicks += engine.ticks;
+        std::printf("%s: %u events, %zu bytes, %d pieces, score %d  %s\n", path, view.info().events, view.size(),
+                    engine.pieces, engine.score, ok ? "ok" : "MISMATCH");
+        if (!ok) ++failures;
+    }
+
+    if (!files.empty() && seconds > 0.0)
+        std::printf("%zu replays in %.4f s: %.0f replays/s, %.0f pieces/s, %.0f ticks/s\n", files.size(), seconds,
+                    files.size() / seconds, totalPieces / seconds, totalTicks / seconds);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+// Headless batch simulator: plays many complete games in parallel with a bot
+// and reports throughput plus the lines and score distributions. Game i uses
+// randomizer stream i of the seed, so a run is reproducible for any thread
+// count and two runs with the same seed see the same piece sequences.
+//
+//   tetris_sim --games 1000 --bot beam --width 8 --depth 2 --out games.csv
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "bot.hpp"
+#include "engine.hpp"
+#include "thread_pool.hpp"
+
+struct GameResult {
+    int pieces;
+    int lines;
+    int score;
+    bool toppedOut;
+};
+
+struct Options {
+    int games = 100;
+    unsigned threads = 0;
+    bool greedy = false;
+    int width = 8;
+    int depth = 2;
+    int maxPieces = 10000;
+    std::uint64_t seed = 1;
+    RandomizerMode mode = RandomizerMode::Bag7;
+    const char* outPath = nullptr;
+};
+
+static bool parseArgs(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--games") && hasValue) o.games = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && hasValue) o.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--bot") && hasValue) {
+            const char* name = argv[++i];
+            if (!std::strcmp(name, "greedy")) o.greedy = true;
+            else if (!std::strcmp(name, "beam")) o.greedy = false;
+            else return false;
+        }
+        else if (!std::strcmp(argv[i], "--width") && hasValue) o.width = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--depth") && hasValue) o.depth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--max-pieces") && hasValue) o.maxPieces = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed") && hasValue) o.seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (!std::strcmp(argv[i], "--randomizer") && hasValue) {
+            if (!Randomizer::parseMode(argv[++i], o.mode)) return false;
+        }
+        else if (!std::strcmp(argv[i], "--out") && hasValue) o.outPath = argv[++i];
+        else return false;
+    }
+    return o.games > 0 && o.maxPieces > 0;
+}
+
+// min, p10, p50, p90, max and mean of one column
+static void distribution(const char* name, std::vector<int> values) {
+    std::sort(values.begin(), values.end());
+    const auto at = [&](double q) { return values[static_cast<std::size_t>(q * (values.size() - 1))]; };
+    double sum = 0.0;
+    for (int v : values) sum += v;
+    std::printf("%-6s min %8d  p10 %8d  p50 %8d  p90 %8d  max %8d  mean %10.1f\n",
+                name, values.front(), at(0.1), at(0.5), at(0.9), values.back(), sum / values.size());
+}
+
+static bool writeCsv(const char* path, const Options& o, const std::vector<GameResult>& results) {
+    std::FILE* out = std::fopen(path, "w");
+    if (!out) return false;
+    std::fprintf(out, "game,seed,pieces,lines,score,topped_out\n");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const GameResult& r = results[i];
+        std::fprintf(out, "%zu,%llu,%d,%d,%d,%d\n", i, static_cast<unsigned long long>(o.seed),
+                     r.pieces, r.lines, r.score, r.toppedOut ? 1 : 0);
+    }
+    const bool ok = std::ferror(out) == 0;
+    return std::fclose(out) == 0 && ok;
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parseArgs(argc, argv, o)) {
+        std::fprintf(stderr,
+                     "usage: %s [--games N] [--threads N] [--bot greedy|beam] [--width N] [--depth N]\n"
+                     "          [--max-pieces N] [--seed N] [--randomizer uniform|7bag|14bag] [--out games.csv]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    // games run in parallel, each search on the thread that plays it
+    BotConfig config{o.width, o.depth, std::chrono::microseconds(0)};
+    if (o.greedy) config = {1, 1, std::chrono::microseconds(0)};
+
+    ThreadPool pool(o.threads);
+    std::vector<std::unique_ptr<BeamSearch>> bots;
+    std::vector<std::unique_ptr<Engine>> engines;
+    for (unsigned i = 0; i < pool.size(); ++i) {
+        bots.push_back(std::make_unique<BeamSearch>(config));
+        engines.push_back(std::make_unique<Engine>(o.seed, o.mode));
+    }
+
+    std::vector<GameResult> results(o.games);
+    const Randomizer base(o.seed, o.mode);
+    const auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(results.size(), [&](std::size_t game, unsigned worker) {
+        Engine& engine = *engines[worker];
+        engine.randomizer = base.stream(game);
+        engine.restart();
+        playOut(engine, *bots[worker], o.maxPieces);
+        results[game] = {engine.pieces, engine.lines, engine.score, engine.gameOver};
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t pieces = 0;
+    int toppedOut = 0;
+    std::vector<int> lines, scores;
+    for (const GameResult& r : results) {
+        pieces += r.pieces;
+        toppedOut += r.toppedOut;
+        lines.push_back(r.lines);
+        scores.push_back(r.score);
+    }
+
+    std::printf("%d games, %s bot (width %d, depth %d), %s, %u threads, cap %d pieces\n",
+                o.games, o.greedy ? "greedy" : "beam", config.beamWidth, config.depth,
+                Randomizer::modeName(o.mode), pool.size(), o.maxPieces);
+    std::printf("%.3f s  %.1f games/s  %.0f pieces/s  %d topped out\n",
+                seconds, o.games / seconds, pieces / seconds, toppedOut);
+    distribution("lines", lines);
+    distribution("score", scores);
+
+    if (o.outPath && !writeCsv(o.outPath, o, results)) {
+        std::fprintf(stderr, "Failed to write %s\n", o.outPath);
+        return 1;
+    }
+    return 0;
+}
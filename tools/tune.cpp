@@ -0,0 +1,280 @@
+// Evaluator weight tuner. Each generation samples a population of weight
+// vectors around a mean, plays every candidate through the same seeded games
+// and moves the mean and the per-feature spread towards the best ones
+// (cross-entropy method with a diagonal covariance, a cheap relative of
+// CMA-ES). Fitness is the mean score over the generation's games.
+//
+// Sampling happens on the main thread from a seeded generator and game i of a
+// generation always draws from the same randomizer stream, so a run - and a
+// run resumed from a checkpoint - is reproducible for any thread count.
+//
+//   tetris_tune --generations 50 --checkpoint tune.txt
+//   tetris_tune --resume tune.txt --generations 100
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "bot.hpp"
+#include "engine.hpp"
+#include "evaluator.hpp"
+#include "thread_pool.hpp"
+
+struct Options {
+    int generations = 20;
+    int population = 16;
+    // candidates the next mean is taken from
+    int elite = 4;
+    int games = 8;
+    int maxPieces = 500;
+    int width = 1;
+    int depth = 1;
+    unsigned threads = 0;
+    std::uint64_t seed = 1;
+    RandomizerMode mode = RandomizerMode::Uniform;
+    const char* checkpointPath = nullptr;
+    const char* resumePath = nullptr;
+};
+
+// Everything needed to continue a run exactly where it stopped.
+struct State {
+    int generation = 0;
+    std::uint64_t rng = 0;
+    Weights mean = DEFAULT_WEIGHTS;
+    Weights sigma = {};
+    Weights best = DEFAULT_WEIGHTS;
+    double bestFitness = -1.0;
+};
+
+// SplitMix64 plus Box-Muller; the whole generator state is one word, so it
+// goes into the checkpoint as is.
+static double uniform(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (static_cast<double>(z >> 11) + 0.5) * 0x1.0p-53;
+}
+
+static double gaussian(std::uint64_t& state) {
+    const double u = uniform(state);
+    const double v = uniform(state);
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+// Settings a run cannot work with, whether they come from the command line
+// or a checkpoint.
+static bool validOptions(const Options& o) {
+    return o.population > 0 && o.elite > 0 && o.elite <= o.population && o.games > 0 && o.maxPieces > 0;
+}
+
+static bool parseArgs(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--generations") && hasValue) o.generations = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--population") && hasValue) o.population = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--elite") && hasValue) o.elite = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--games") && hasValue) o.games = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--max-pieces") && hasValue) o.maxPieces = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--width") && hasValue) o.width = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--depth") && hasValue) o.depth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && hasValue) o.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--seed") && hasValue) o.seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (!std::strcmp(argv[i], "--randomizer") && hasValue) {
+            if (!Randomizer::parseMode(argv[++i], o.mode)) return false;
+        }
+        else if (!std::strcmp(argv[i], "--checkpoint") && hasValue) o.checkpointPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--resume") && hasValue) o.resumePath = argv[++i];
+        else return false;
+    }
+    return validOptions(o);
+}
+
+// ---- checkpoints -------------------------------------------------------------
+
+static void writeWeights(std::FILE* out, const char* key, const Weights& w) {
+    std::fprintf(out, "%s", key);
+    for (float v : w) std::fprintf(out, " %.9g", v);
+    std::fprintf(out, "\n");
+}
+
+static bool readWeights(std::FILE* in, const char* key, Weights& w) {
+    char name[32];
+    if (std::fscanf(in, "%31s", name) != 1 || std::strcmp(name, key)) return false;
+    for (float& v : w)
+        if (std::fscanf(in, "%f", &v) != 1) return false;
+    return true;
+}
+
+// Plain text so a run can be inspected or hand-edited. Settings that change
+// what a generation computes are stored too and win over the command line.
+// Written beside the old checkpoint and renamed over it, so a crash part way
+// leaves the previous generation's checkpoint intact.
+static bool saveCheckpoint(const char* path, const Options& o, const State& s) {
+    const std::string temp = std::string(path) + ".tmp";
+    std::FILE* out = std::fopen(temp.c_str(), "w");
+    if (!out) return false;
+    std::fprintf(out, "tetris_tune 1\n");
+    std::fprintf(out, "seed %llu\nmode %s\npopulation %d\nelite %d\ngames %d\nmax_pieces %d\nwidth %d\ndepth %d\n",
+                 static_cast<unsigned long long>(o.seed), Randomizer::modeName(o.mode), o.population, o.elite,
+                 o.games, o.maxPieces, o.width, o.depth);
+    std::fprintf(out, "generation %d\nrng %llu\nbest_fitness %.17g\n", s.generation,
+                 static_cast<unsigned long long>(s.rng), s.bestFitness);
+    writeWeights(out, "mean", s.mean);
+    writeWeights(out, "sigma", s.sigma);
+    writeWeights(out, "best", s.best);
+    const bool ok = std::ferror(out) == 0;
+    if (std::fclose(out) != 0 || !ok) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    return !error;
+}
+
+static bool loadCheckpoint(const char* path, Options& o, State& s) {
+    std::FILE* in = std::fopen(path, "r");
+    if (!in) return false;
+    unsigned long long seed = 0, rng = 0;
+    char mode[16];
+    int version = 0;
+    const bool ok =
+        std::fscanf(in, " tetris_tune %d", &version) == 1 && version == 1 &&
+        std::fscanf(in, " seed %llu mode %15s population %d elite %d games %d max_pieces %d width %d depth %d",
+                    &seed, mode, &o.population, &o.elite, &o.games, &o.maxPieces, &o.width, &o.depth) == 8 &&
+        Randomizer::parseMode(mode, o.mode) &&
+        std::fscanf(in, " generation %d rng %llu best_fitness %lf", &s.generation, &rng, &s.bestFitness) == 3 &&
+        readWeights(in, "mean", s.mean) && readWeights(in, "sigma", s.sigma) && readWeights(in, "best", s.best);
+    std::fclose(in);
+    o.seed = seed;
+    s.rng = rng;
+    // a hand-edited checkpoint gets the same checks as the command line
+    return ok && validOptions(o) && s.generation >= 0;
+}
+
+// ---- main --------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parseArgs(argc, argv, o)) {
+        std::fprintf(stderr,
+                     "usage: %s [--generations N] [--population N] [--elite N] [--games N] [--max-pieces N]\n"
+                     "          [--width N] [--depth N] [--threads N] [--seed N] [--randomizer uniform|7bag|14bag]\n"
+                     "          [--checkpoint file] [--resume file]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    State state;
+    if (o.resumePath) {
+        if (!loadCheckpoint(o.resumePath, o, state)) {
+            std::fprintf(stderr, "Failed to read checkpoint %s\n", o.resumePath);
+            return 1;
+        }
+        std::printf("resumed %s at generation %d\n", o.resumePath, state.generation);
+    } else {
+        state.rng = o.seed;
+        for (int f = 0; f < FEATURE_COUNT; ++f)
+            state.sigma[f] = std::max(std::fabs(state.mean[f]) * 0.5f, 0.5f);
+    }
+
+    // Per-worker game buffers. The evaluator reads the worker's weight slot,
+    // which is set before each game, so nothing is rebuilt per candidate.
+    ThreadPool pool(o.threads);
+    const BotConfig config{o.width, o.depth, std::chrono::microseconds(0)};
+    std::vector<Weights> workerWeights(pool.size());
+    std::vector<std::unique_ptr<BeamSearch>> bots;
+    std::vector<std::unique_ptr<Engine>> engines;
+    for (unsigned i = 0; i < pool.size(); ++i) {
+        const Weights* weights = &workerWeights[i];
+        bots.push_back(std::make_unique<BeamSearch>(config, [weights](const Grid& grid, int lines) {
+            return evaluateBoard(grid, lines, *weights);
+        }));
+        engines.push_back(std::make_unique<Engine>(o.seed, o.mode));
+    }
+
+    std::vector<Weights> candidates(o.population);
+    std::vector<double> scores(static_cast<std::size_t>(o.population) * o.games);
+    std::vector<double> fitness(o.population);
+    std::vector<int> order(o.population);
+    const Randomizer base(o.seed, o.mode);
+
+    std::printf("gen   best fit   mean fit   mean sigma   gen/h\n");
+    const auto start = std::chrono::steady_clock::now();
+    const int lastGeneration = state.generation + o.generations;
+    for (; state.generation < lastGeneration; ++state.generation) {
+        for (Weights& c : candidates)
+            for (int f = 0; f < FEATURE_COUNT; ++f)
+                c[f] = state.mean[f] + state.sigma[f] * static_cast<float>(gaussian(state.rng));
+
+        // candidate-major, so neighbouring tasks share a weight vector
+        const std::uint64_t firstStream = static_cast<std::uint64_t>(state.generation) * o.games;
+        pool.parallelFor(scores.size(), [&](std::size_t task, unsigned worker) {
+            const std::size_t candidate = task / o.games;
+            const std::size_t game = task % o.games;
+            workerWeights[worker] = candidates[candidate];
+            Engine& engine = *engines[worker];
+            engine.randomizer = base.stream(firstStream + game);
+            engine.restart();
+            playOut(engine, *bots[worker], o.maxPieces);
+            scores[task] = engine.score;
+        });
+
+        for (int c = 0; c < o.population; ++c) {
+            const double* s = &scores[static_cast<std::size_t>(c) * o.games];
+            fitness[c] = std::accumulate(s, s + o.games, 0.0) / o.games;
+        }
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] > fitness[b]; });
+
+        // new mean and spread from the elite; the floor keeps the search from
+        // collapsing onto a noisy early winner
+        Weights mean = {};
+        for (int e = 0; e < o.elite; ++e)
+            for (int f = 0; f < FEATURE_COUNT; ++f) mean[f] += candidates[order[e]][f] / o.elite;
+        for (int f = 0; f < FEATURE_COUNT; ++f) {
+            float var = 0.f;
+            for (int e = 0; e < o.elite; ++e) {
+                const float d = candidates[order[e]][f] - mean[f];
+                var += d * d / o.elite;
+            }
+            state.sigma[f] = std::max(std::sqrt(var), 0.05f);
+        }
+        state.mean = mean;
+
+        const double meanFitness = std::accumulate(fitness.begin(), fitness.end(), 0.0) / o.population;
+        if (fitness[order[0]] > state.bestFitness) {
+            state.bestFitness = fitness[order[0]];
+            state.best = candidates[order[0]];
+        }
+
+        const double hours = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 3600.0;
+        const int done = state.generation + 1 - (lastGeneration - o.generations);
+        const float meanSigma = std::accumulate(state.sigma.begin(), state.sigma.end(), 0.f) / static_cast<float>(FEATURE_COUNT);
+        std::printf("%3d %10.1f %10.1f %12.3f %7.1f\n", state.generation, fitness[order[0]], meanFitness,
+                    meanSigma, done / hours);
+        std::fflush(stdout);
+
+        if (o.checkpointPath) {
+            State next = state;
+            ++next.generation;
+            if (!saveCheckpoint(o.checkpointPath, o, next))
+                std::fprintf(stderr, "Failed to write checkpoint %s\n", o.checkpointPath);
+        }
+    }
+
+    std::printf("best fitness %.1f\nconst Weights DEFAULT_WEIGHTS = {", state.bestFitness);
+    for (int f = 0; f < FEATURE_COUNT; ++f) std::printf("%s%.3ff", f ? ", " : "", state.best[f]);
+    std::printf("};\n");
+    return 0;
+}